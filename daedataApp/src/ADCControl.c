@@ -1,12 +1,13 @@
-/** @file charToStringWaveform.c
- *  @author Freddie Akeroyd, STFC (freddie.akeroyd@stfc.ac.uk)
+/** @file ADCControl.c
  *  @ingroup asub_functions
  *
- *  Copy a CHAR waveform record into a STRING waveform record. If this is done by
- *  a normal CAPUT the character byte codes are not preserved
+ *  aSub record functions to decode and encode the DSP control words of FPGA ADC channels,
+ *  laid out as ADCControlBits in an 8 word block per channel (the last two words unused).
  *
- *  It expect the A input to be the waveform data and B to be "NORD" (number of elements)
- *  it write its output to VALA
+ *  ADCReadControlReg/ADCWriteControlReg handle one channel: A (ULONG, 8 elements) to the
+ *  14 fields in VALA..VALN, and fields A..N to VALA (ULONG, 8 elements).
+ *  ADCReadControlRegs/ADCWriteControlRegs do the same for N channels at once, with the
+ *  blocks back to back in the array and element i of each field array for channel i.
  */
 #include <string.h>
 #include <registryFunction.h>
@@ -16,11 +17,6 @@
 #include <stdint.h>
 
 #include <epicsExport.h>
-/**
- *  Convert a character waveform into a string waveform
- *  @ingroup asub_functions
- *  @param[in] prec Pointer to aSub record
- */
 
 //struct ADCControlBits
 //{
@@ -71,6 +67,11 @@ typedef struct
 
 #define ADC_STRUCT_WORDS 6 /* how many 32 bit integers in struct adc */
 #define ADC_STRUCT_SIZE (ADC_STRUCT_WORDS * sizeof(epicsUInt32)) /* how big struct adc should be - used as a test of byte alignment */
+#define ADC_BLOCK_WORDS 8 /* words per channel in DAE memory, the last two unused */
+#define ADC_NFIELDS 14 /* fields of struct adc, in aSub argument order A to N */
+
+/* fails to compile if the bit fields are not packed as the DAE lays them out */
+typedef char ADCControlBitsSizeCheck[(sizeof(ADCControlBits) == ADC_STRUCT_SIZE) ? 1 : -1];
 
 /* 
  * macros to handle values like uld that are split over boundaries as uld0 and uld1
@@ -87,92 +88,197 @@ typedef struct
 #define get_prescale_selection(adc)       get_field(adc,prescale_selection,7)
 #define set_prescale_selection(adc,val)   set_field(adc,prescale_selection,7,val)
 
-static long ADCReadControlReg(aSubRecord *prec)
+/* decode the control block of channel i of words into element i of each field array */
+static void adcDecode(const epicsUInt32* words, size_t i, epicsInt32* const fields[ADC_NFIELDS])
 {
     ADCControlBits adc;
-    // static_assert(sizeof(adc) == ADC_STRUCT_SIZE, "struct adc size wrong");
+    memcpy(&adc, words + i * ADC_BLOCK_WORDS, sizeof(adc));
+    fields[0][i] = adc.spec_select;
+    fields[1][i] = adc.overflow_select;
+    fields[2][i] = adc.dsp_gain;
+    fields[3][i] = adc.accept_all;
+    fields[4][i] = adc.lld;
+    fields[5][i] = adc.start_slope_cut;
+    fields[6][i] = get_uld(adc);
+    fields[7][i] = adc.second_deriv_cut;
+    fields[8][i] = adc.max_slope_cut;
+    fields[9][i] = get_prescale_selection(adc);
+    fields[10][i] = adc.start_slope_bits;
+    fields[11][i] = adc.max_slope_bits;
+    fields[12][i] = adc.second_deriv_bits;
+    fields[13][i] = adc.misplace_bits;
+}
+
+/* encode element i of each field array into the control block of channel i of words, unused bits zero */
+static void adcEncode(const epicsInt32* const fields[ADC_NFIELDS], size_t i, epicsUInt32* words)
+{
+    ADCControlBits adc;
+    memset(&adc, 0, sizeof(adc));
+    adc.spec_select = fields[0][i];
+    adc.overflow_select = fields[1][i];
+    adc.dsp_gain = fields[2][i];
+    adc.accept_all = fields[3][i];
+    adc.lld = fields[4][i];
+    adc.start_slope_cut = fields[5][i];
+    set_uld(adc, fields[6][i]);
+    adc.second_deriv_cut = fields[7][i];
+    adc.max_slope_cut = fields[8][i];
+    set_prescale_selection(adc, fields[9][i]);
+    adc.start_slope_bits = fields[10][i];
+    adc.max_slope_bits = fields[11][i];
+    adc.second_deriv_bits = fields[12][i];
+    adc.misplace_bits = fields[13][i];
+    memset(words + i * ADC_BLOCK_WORDS, 0, ADC_BLOCK_WORDS * sizeof(epicsUInt32));
+    memcpy(words + i * ADC_BLOCK_WORDS, &adc, sizeof(adc));
+}
+
+/* decode nchan control blocks from A into VALA..VALN for the batch function, checking the types and sizes */
+static long adcReadControlRegs(aSubRecord *prec, epicsUInt32 nchan)
+{
+    void** val = &prec->vala;
+    epicsEnum16* ftv = &prec->ftva;
+    epicsUInt32* nov = &prec->nova;
+    epicsUInt32* nev = &prec->neva;
+    epicsInt32* fields[ADC_NFIELDS];
+    epicsUInt32 i;
+    if (prec->fta != menuFtypeULONG)
+    {
+         errlogSevPrintf(errlogMajor, "%s incorrect input type. A (ULONG)\n", prec->name);
+		 return -1;
+    }
+    for(i=0; i<ADC_NFIELDS; ++i)
+    {
+        if (ftv[i] != menuFtypeLONG || nov[i] < nchan)
+        {
+             errlogSevPrintf(errlogMajor, "%s VAL%c must be LONG with at least %u elements\n", prec->name, 'A' + i, nchan);
+             return -1;
+        }
+        fields[i] = (epicsInt32*)val[i];
+    }
+    for(i=0; i<nchan; ++i)
+    {
+        adcDecode((const epicsUInt32*)prec->a, i, fields);
+    }
+    for(i=0; i<ADC_NFIELDS; ++i)
+    {
+        nev[i] = nchan;
+    }
+    return 0;
+}
+
+/* encode nchan channels from A..N into VALA for the batch function, checking the types and sizes */
+static long adcWriteControlRegs(aSubRecord *prec, epicsUInt32 nchan)
+{
+    void** in = &prec->a;
+    epicsEnum16* ft = &prec->fta;
+    epicsUInt32* ne = &prec->nea;
+    const epicsInt32* fields[ADC_NFIELDS];
+    epicsUInt32 i;
+    if (prec->ftva != menuFtypeULONG || prec->nova < nchan * ADC_BLOCK_WORDS)
+    {
+         errlogSevPrintf(errlogMajor, "%s VALA must be ULONG with at least %u elements\n", prec->name, nchan * ADC_BLOCK_WORDS);
+		 return -1;
+    }
+    for(i=0; i<ADC_NFIELDS; ++i)
+    {
+        if (ft[i] != menuFtypeLONG || ne[i] < nchan)
+        {
+             errlogSevPrintf(errlogMajor, "%s %c must be LONG with at least %u elements\n", prec->name, 'A' + i, nchan);
+             return -1;
+        }
+        fields[i] = (const epicsInt32*)in[i];
+    }
+    memset(prec->vala, 0, prec->nova * sizeof(epicsUInt32));
+    for(i=0; i<nchan; ++i)
+    {
+        adcEncode(fields, i, (epicsUInt32*)prec->vala);
+    }
+    prec->neva = nchan * ADC_BLOCK_WORDS;
+    return 0;
+}
+
+/*
+ * single channel decode of A into element 0 of VALA..VALN. Only A and VALA are checked, as 
+ * before the batch functions were added, so records with other types in VALB..VALN keep loading
+ */
+static long ADCReadControlReg(aSubRecord *prec)
+{
+    epicsInt32* fields[ADC_NFIELDS];
+    void** val = &prec->vala;
+    int i;
     if (prec->fta != menuFtypeULONG || prec->ftva != menuFtypeLONG)
     {
          errlogSevPrintf(errlogMajor, "%s incorrect input type. A (ULONG), VALA (LONG)\n", prec->name);
 		 return -1;
     }
-    if (prec->noa != 8)
+    if (prec->noa != ADC_BLOCK_WORDS)
     {
          errlogSevPrintf(errlogMajor, "%s incorrect input array length %d != 8.\n", prec->name, prec->noa);
 		 return -1;        
     }
-    if (sizeof(adc) != ADC_STRUCT_SIZE)
-    {
-         errlogSevPrintf(errlogMajor, "%s incorrect ADCControlBits size %lu bytes\n", prec->name, sizeof(adc));
-		 return -1;        
-    }        
-    if (sizeof(adc) > prec->noa * sizeof(epicsUInt32))
+    for(i=0; i<ADC_NFIELDS; ++i)
     {
-         errlogSevPrintf(errlogMajor, "%s NOA not big enough %d\n", prec->name, prec->nova);
-		 return -1;        
-    }        
-    memcpy(&adc, prec->a, sizeof(adc));
-    *(epicsInt32*)(prec->vala) = adc.spec_select;
-    *(epicsInt32*)(prec->valb) = adc.overflow_select;
-    *(epicsInt32*)(prec->valc) = adc.dsp_gain;
-    *(epicsInt32*)(prec->vald) = adc.accept_all;
-    *(epicsInt32*)(prec->vale) = adc.lld;
-    *(epicsInt32*)(prec->valf) = adc.start_slope_cut;
-    *(epicsInt32*)(prec->valg) = get_uld(adc);
-    *(epicsInt32*)(prec->valh) = adc.second_deriv_cut;
-    *(epicsInt32*)(prec->vali) = adc.max_slope_cut;
-    *(epicsInt32*)(prec->valj) = get_prescale_selection(adc);
-    *(epicsInt32*)(prec->valk) = adc.start_slope_bits;
-    *(epicsInt32*)(prec->vall) = adc.max_slope_bits;
-    *(epicsInt32*)(prec->valm) = adc.second_deriv_bits;
-    *(epicsInt32*)(prec->valn) = adc.misplace_bits;
+        fields[i] = (epicsInt32*)val[i];
+    }
+    adcDecode((const epicsUInt32*)prec->a, 0, fields);
 	return 0;
 }
     
+/* single channel encode of element 0 of A..N into VALA, checking only A and VALA as ADCReadControlReg */
 static long ADCWriteControlReg(aSubRecord *prec) 
 {
-    ADCControlBits adc;
-    // static_assert(sizeof(adc) == ADC_STRUCT_SIZE, "struct adc size wrong");
+    const epicsInt32* fields[ADC_NFIELDS];
+    void** in = &prec->a;
+    int i;
     if (prec->fta != menuFtypeLONG || prec->ftva != menuFtypeULONG)
     {
          errlogSevPrintf(errlogMajor, "%s incorrect input type. A (LONG), VALA (ULONG)\n", prec->name);
 		 return -1;
     }
-    if (prec->nova != 8)
+    if (prec->nova != ADC_BLOCK_WORDS)
     {
          errlogSevPrintf(errlogMajor, "%s incorrect output array length %d != 8.\n", prec->name, prec->nova);
 		 return -1;        
     }
-    if (sizeof(adc) != ADC_STRUCT_SIZE)
+    for(i=0; i<ADC_NFIELDS; ++i)
+    {
+        fields[i] = (const epicsInt32*)in[i];
+    }
+    adcEncode(fields, 0, (epicsUInt32*)prec->vala);
+    prec->neva = ADC_STRUCT_WORDS;
+    return 0;
+}
+
+/*
+ * batch decode: A holds the 8 word control blocks of N channels back to back (e.g. one waveform 
+ * reading them all in a single block read), N taken from the number of elements read. Field f of 
+ * channel i goes to element i of VALA..VALN, which need NOVx >= N
+ */
+static long ADCReadControlRegs(aSubRecord *prec)
+{
+    if (prec->nea == 0 || prec->nea % ADC_BLOCK_WORDS != 0)
     {
-         errlogSevPrintf(errlogMajor, "%s incorrect ADCControlBits size %lu bytes\n", prec->name, sizeof(adc));
+         errlogSevPrintf(errlogMajor, "%s input array length %u is not a multiple of 8.\n", prec->name, prec->nea);
 		 return -1;        
-    }        
-    if (sizeof(adc) > prec->nova * sizeof(epicsUInt32))
+    }
+    return adcReadControlRegs(prec, prec->nea / ADC_BLOCK_WORDS);
+}
+
+/*
+ * batch encode: element i of A..N are the fields of channel i, N taken from the number of elements 
+ * in A. VALA gets N control blocks of 8 words back to back, ready for one block write
+ */
+static long ADCWriteControlRegs(aSubRecord *prec) 
+{
+    if (prec->nea == 0)
     {
-         errlogSevPrintf(errlogMajor, "%s nova not big enough %d\n", prec->name, prec->nova);
+         errlogSevPrintf(errlogMajor, "%s no channels in A.\n", prec->name);
 		 return -1;        
-    }        
-    memset(&adc, 0, sizeof(adc));
-    memset(prec->vala, 0, prec->nova * sizeof(epicsUInt32));
-    adc.spec_select = *(epicsInt32*)(prec->a);
-    adc.overflow_select = *(epicsInt32*)(prec->b);
-    adc.dsp_gain = *(epicsInt32*)(prec->c);
-    adc.accept_all =*(epicsInt32*)(prec->d);
-    adc.lld = *(epicsInt32*)(prec->e);
-    adc.start_slope_cut = *(epicsInt32*)(prec->f);
-    set_uld(adc, *(epicsInt32*)(prec->g));
-    adc.second_deriv_cut = *(epicsInt32*)(prec->h);
-    adc.max_slope_cut = *(epicsInt32*)(prec->i);
-    set_prescale_selection(adc, *(epicsInt32*)(prec->j));
-    adc.start_slope_bits = *(epicsInt32*)(prec->k);
-    adc.max_slope_bits = *(epicsInt32*)(prec->l);
-    adc.second_deriv_bits = *(epicsInt32*)(prec->m);
-    adc.misplace_bits = *(epicsInt32*)(prec->n);
-    memcpy(prec->vala, &adc, sizeof(adc));
-    prec->neva = ADC_STRUCT_WORDS;
-    return 0;
+    }
+    return adcWriteControlRegs(prec, prec->nea);
 }
 
 epicsRegisterFunction(ADCReadControlReg); /* must also be mentioned in daedataSupport.dbd */
 epicsRegisterFunction(ADCWriteControlReg); /* must also be mentioned in daedataSupport.dbd */
+epicsRegisterFunction(ADCReadControlRegs); /* must also be mentioned in daedataSupport.dbd */
+epicsRegisterFunction(ADCWriteControlRegs); /* must also be mentioned in daedataSupport.dbd */
@@ -0,0 +1,168 @@
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <sstream>
+
+#include "daedataAddress.h"
+
+DAEDataAddress::DAEDataAddress() : address(0), nwords(0), scan(0.0), deadband(0), max_age(0.0), verify(true), width(16), order(HalfOrderNative), offset(0)
+{
+}
+
+/// parse drvInfo of the form "0x<address> [scan=<seconds>] [n=<words>] [age=<seconds>] [verify=0|1] [width=16|32] [order=native|hi|lo] [offset=<value>] [bits=<bit>[:<width>]] [deadband=<value>]"
+/// \return true if drvInfo is valid, otherwise false with error set
+bool DAEDataAddress::parse(const char* drvInfo, std::string& error)
+{
+    std::string info(drvInfo);
+    size_t pos = 0;
+    bool first = true;
+    std::string int16_option;   // a modifier only 16 bit array records use, if given
+    while( (pos = info.find_first_not_of(" \t", pos)) != std::string::npos )
+    {
+        size_t end = info.find_first_of(" \t", pos);
+        std::string token = info.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        pos = end;
+        char* endp = NULL;
+        if (first)
+        {
+            first = false;
+            address = strtoul(token.c_str(), &endp, 16);
+            if (token.compare(0, 2, "0x") != 0 || token.size() == 2 || *endp != '\0')
+            {
+                error = "invalid address \"" + token + "\"";
+                return false;
+            }
+            if (address % 4 != 0)
+            {
+                error = "address \"" + token + "\" is not word aligned";
+                return false;
+            }
+            continue;
+        }
+        size_t eq = token.find('=');
+        if (eq == std::string::npos || eq + 1 == token.size())
+        {
+            error = "expected name=value, got \"" + token + "\"";
+            return false;
+        }
+        std::string name = token.substr(0, eq);
+        const char* value = token.c_str() + eq + 1;
+        if (name == "scan" || name == "age")
+        {
+            double d = strtod(value, &endp);
+            if (*endp != '\0' || d < 0.0)
+            {
+                error = "invalid " + token;
+                return false;
+            }
+            (name == "scan" ? scan : max_age) = d;
+        }
+        else if (name == "n" || name == "verify" || name == "width" || name == "offset" || name == "deadband")
+        {
+            long l = strtol(value, &endp, 0);
+            if (*endp != '\0' || (name == "n" && l <= 0) || (name == "deadband" && l < 0) || (name == "verify" && l != 0 && l != 1) || 
+               (name == "width" && l != 16 && l != 32) || (name == "offset" && (l < -0xffff || l > 0xffff)))
+            {
+                error = "invalid " + token;
+                return false;
+            }
+            if (name == "n")
+            {
+                nwords = l;
+            }
+            else if (name == "verify")
+            {
+                verify = (l != 0);
+            }
+            else if (name == "width")
+            {
+                width = l;
+                int16_option = name;
+            }
+            else if (name == "deadband")
+            {
+                deadband = l;
+            }
+            else
+            {
+                offset = l;
+                int16_option = name;
+            }
+        }
+        else if (name == "bits")
+        {
+            unsigned long bit = strtoul(value, &endp, 0), bits = 1;
+            if (*endp == ':')
+            {
+                bits = strtoul(endp + 1, &endp, 0);
+            }
+            if (*endp != '\0' || !isdigit(value[0]) || bits == 0 || bits > 32 || bit > 0xffff)
+            {
+                error = "invalid " + token;
+                return false;
+            }
+            field = DAEDataRegisterMap::Field();
+            field.name = token;
+            field.width = 0;
+            DAEDataRegisterMap::addPart(field, bit / 32, bit % 32, bits);
+        }
+        else if (name == "order")
+        {
+            if (strcmp(value, "native") == 0)
+            {
+                order = HalfOrderNative;
+            }
+            else if (strcmp(value, "hi") == 0)
+            {
+                order = HalfOrderHighFirst;
+            }
+            else if (strcmp(value, "lo") == 0)
+            {
+                order = HalfOrderLowFirst;
+            }
+            else
+            {
+                error = "invalid " + token;
+                return false;
+            }
+            int16_option = name;
+        }
+        else
+        {
+            error = "unknown modifier \"" + token + "\"";
+            return false;
+        }
+    }
+    if (first)
+    {
+        error = "no address";
+        return false;
+    }
+    if (deadband > 0 && scan <= 0.0)
+    {
+        error = "deadband= only applies to polled addresses, give scan= too";
+        return false;
+    }
+    if (scan > 0.0 && !int16_option.empty())
+    {
+        // this also keeps deadband=, which compares whole words, away from width=16 and its two values a word
+        error = int16_option + "= is for 16 bit array records, which cannot be polled: scan= values are posted as 32 bit words";
+        return false;
+    }
+    if (!field.parts.empty() && (scan > 0.0 || nwords > 1))
+    {
+        error = "bits= is for single values that are not polled, use a register map to poll fields";
+        return false;
+    }
+    return true;
+}
+
+/// \return a name for the poll parameter of a polled address, the same for every drvInfo giving the same 
+/// address and polling options however they are written e.g. "0x1000 scan=1" and "0x1000  n=1 scan=1.0"
+std::string DAEDataAddress::pollKey() const
+{
+    std::ostringstream oss;
+    oss << "0x" << std::hex << address << std::dec << " n=" << (nwords > 0 ? nwords : 1) << " scan=" << scan << " deadband=" << deadband;
+    return oss.str();
+}
@@ -0,0 +1,36 @@
+#ifndef DAEDATAADDRESS_H
+#define DAEDATAADDRESS_H
+
+#include <string>
+
+#include "daedataRegisterMap.h"
+
+/// A DAE memory address drvInfo such as "0x10004 scan=1 n=8", parsed once by daedataDriver::drvUserCreate()
+/// and kept in the asynUser for the I/O methods to use. Modifiers after the address are optional. Polled (scan=)
+/// values are posted as asynInt32 or asynInt32Array words, so the 16 bit modifiers width=, order= and offset= cannot go with scan=
+struct DAEDataAddress
+{
+    /// how 16 bit record elements are laid out in each 32 bit DAE word
+    enum HalfOrder 
+    { 
+        HalfOrderNative,    ///< host memory order, i.e. a straight copy of the words
+        HalfOrderHighFirst, ///< high 16 bits is the first element
+        HalfOrderLowFirst   ///< low 16 bits is the first element
+    };
+    unsigned address;     ///< byte address of the first word
+    size_t nwords;        ///< "n=" number of words, 0 if not given
+    double scan;          ///< "scan=" poll period in seconds, 0 if not polled
+    unsigned deadband;    ///< "deadband=" with scan, a polled word is only posted once it differs from the value last posted by more than this
+    double max_age;       ///< "age=" maximum age in seconds of a shadow memory read, 0 to always read the hardware
+    bool verify;          ///< "verify=0" to skip reading back and checking writes
+    int width;            ///< "width=" bits of DAE word per 16 bit record element, 16 (two per word) or 32 (one per word)
+    HalfOrder order;      ///< "order=" native, hi or lo, used when width is 16
+    int offset;           ///< "offset=" added to each 16 bit element read and subtracted from each written, e.g. 0x8000 for offset binary data
+    DAEDataRegisterMap::Field field;  ///< "bits=<bit>[:<width>]" a bit field of the memory from address on, counted as in a register map. 
+                                      ///< Reads return just the field and writes are a read-modify-write of it. No parts if not given
+    DAEDataAddress();
+    bool parse(const char* drvInfo, std::string& error);
+    std::string pollKey() const;
+};
+
+#endif /* DAEDATAADDRESS_H */
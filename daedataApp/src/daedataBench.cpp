@@ -0,0 +1,175 @@
+/// Benchmark of the datagram payload conversion kernels in daedataKernels.cpp against the plain
+/// ntohl()/htonl() loops (plus a second 16 bit unpack pass) that they replaced. Each compiled in
+/// kernel set supported by this CPU is checked against the scalar kernels before being timed.
+///
+/// usage: daedataBench [words [repeats]]
+/// with no arguments a single datagram (256 words) and a 4M word (16MB) transfer are timed
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <stdint.h>
+
+#include <osiSock.h>
+#include <epicsTime.h>
+
+#include "daedataKernels.h"
+
+static const char* layout_names[DAEDataNumLayouts] = { "32", "halves hi", "halves lo", "low16" };
+
+/// elements in a host buffer of nwords DAE words
+static size_t hostElements(int layout, size_t nwords)
+{
+    return (layout == DAEDataLayoutLow16 || layout == DAEDataLayout32 ? nwords : 2 * nwords);
+}
+
+/// the old path: byte swap every word into a staging buffer, then unpack 16 bit elements in a second pass
+static void loopDecode(int layout, const uint32_t* wire, uint32_t* staging, void* host, size_t nwords)
+{
+    for(size_t i=0; i<nwords; ++i)
+    {
+        staging[i] = ntohl(wire[i]);
+    }
+    uint16_t* h = (uint16_t*)host;
+    switch(layout)
+    {
+    case DAEDataLayoutHalvesHigh:
+        for(size_t i=0; i<nwords; ++i)
+        {
+            h[2 * i] = (uint16_t)(staging[i] >> 16);
+            h[2 * i + 1] = (uint16_t)staging[i];
+        }
+        break;
+    case DAEDataLayoutHalvesLow:
+        memcpy(host, staging, nwords * sizeof(uint32_t));
+        break;
+    case DAEDataLayoutLow16:
+        for(size_t i=0; i<nwords; ++i)
+        {
+            h[i] = (uint16_t)staging[i];
+        }
+        break;
+    default:
+        memcpy(host, staging, nwords * sizeof(uint32_t));
+        break;
+    }
+}
+
+/// the old path in reverse: pack 16 bit elements into a staging buffer, then byte swap every word
+static void loopEncode(int layout, const void* host, uint32_t* staging, uint32_t* wire, size_t nwords)
+{
+    const uint16_t* h = (const uint16_t*)host;
+    switch(layout)
+    {
+    case DAEDataLayoutHalvesHigh:
+        for(size_t i=0; i<nwords; ++i)
+        {
+            staging[i] = ((uint32_t)h[2 * i] << 16) | h[2 * i + 1];
+        }
+        break;
+    case DAEDataLayoutLow16:
+        for(size_t i=0; i<nwords; ++i)
+        {
+            staging[i] = h[i];
+        }
+        break;
+    default:
+        memcpy(staging, host, nwords * sizeof(uint32_t));
+        break;
+    }
+    for(size_t i=0; i<nwords; ++i)
+    {
+        wire[i] = htonl(staging[i]);
+    }
+}
+
+/// \return MB of datagram payload per second
+static double rate(size_t nwords, int repeats, const epicsTime& start)
+{
+    double t = epicsTime::getCurrent() - start;
+    return (t > 0.0 ? 4.0 * nwords * repeats / t / 1e6 : 0.0);
+}
+
+static bool benchmark(size_t nwords, int repeats)
+{
+    bool ok = true;
+    std::vector<uint32_t> wire(nwords), wire_out(nwords), wire_ref(nwords), staging(nwords);
+    std::vector<uint32_t> host(nwords), host_ref(nwords);
+    for(size_t i=0; i<nwords; ++i)
+    {
+        wire[i] = (uint32_t)rand() ^ ((uint32_t)rand() << 16);
+    }
+    printf("%lu words x %d\n", (unsigned long)nwords, repeats);
+    printf("%-10s %-8s %12s %12s %8s %8s\n", "layout", "kernels", "decode MB/s", "encode MB/s", "decode x", "encode x");
+    for(int layout=0; layout<DAEDataNumLayouts; ++layout)
+    {
+        epicsTime start = epicsTime::getCurrent();
+        for(int r=0; r<repeats; ++r)
+        {
+            loopDecode(layout, &(wire[0]), &(staging[0]), &(host[0]), nwords);
+        }
+        double loop_decode = rate(nwords, repeats, start);
+        start = epicsTime::getCurrent();
+        for(int r=0; r<repeats; ++r)
+        {
+            loopEncode(layout, &(host[0]), &(staging[0]), &(wire_out[0]), nwords);
+        }
+        double loop_encode = rate(nwords, repeats, start);
+        printf("%-10s %-8s %12.0f %12.0f\n", layout_names[layout], "loops", loop_decode, loop_encode);
+        const DAEDataKernels* scalar = daedataFindKernels("scalar");
+        scalar->decode[layout](&(wire[0]), &(host_ref[0]), nwords, 0x8000);
+        scalar->encode[layout](&(host_ref[0]), &(wire_ref[0]), nwords, 0x8000);
+        size_t host_bytes = hostElements(layout, nwords) * (layout == DAEDataLayout32 ? 4 : 2);
+        for(size_t k=0; daedataKernelsAt(k) != NULL; ++k)
+        {
+            const DAEDataKernels* kernels = daedataKernelsAt(k);
+            // odd lengths exercise the scalar tail of the vector kernels
+            size_t nodd = (nwords > 3 ? nwords - 3 : nwords);
+            memset(&(host[0]), 0, host_bytes);
+            kernels->decode[layout](&(wire[0]), &(host[0]), nodd, 0x8000);
+            kernels->encode[layout](&(host_ref[0]), &(wire_out[0]), nodd, 0x8000);
+            if (memcmp(&(host[0]), &(host_ref[0]), hostElements(layout, nodd) * (layout == DAEDataLayout32 ? 4 : 2)) != 0 ||
+                memcmp(&(wire_out[0]), &(wire_ref[0]), nodd * 4) != 0)
+            {
+                printf("%-10s %-8s differs from scalar\n", layout_names[layout], kernels->name);
+                ok = false;
+                continue;
+            }
+            start = epicsTime::getCurrent();
+            for(int r=0; r<repeats; ++r)
+            {
+                kernels->decode[layout](&(wire[0]), &(host[0]), nwords, 0);
+            }
+            double decode = rate(nwords, repeats, start);
+            start = epicsTime::getCurrent();
+            for(int r=0; r<repeats; ++r)
+            {
+                kernels->encode[layout](&(host[0]), &(wire_out[0]), nwords, 0);
+            }
+            double encode = rate(nwords, repeats, start);
+            printf("%-10s %-8s %12.0f %12.0f %8.2f %8.2f\n", layout_names[layout], kernels->name, decode, encode,
+                (loop_decode > 0.0 ? decode / loop_decode : 0.0), (loop_encode > 0.0 ? encode / loop_encode : 0.0));
+        }
+    }
+    printf("\n");
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    bool ok = true;
+    printf("default kernels: %s\n\n", daedataKernels().name);
+    if (argc > 1)
+    {
+        size_t nwords = strtoul(argv[1], NULL, 0);
+        int repeats = (argc > 2 ? atoi(argv[2]) : 1 + (int)(64 * 1024 * 1024 / (nwords + 1)));
+        ok = benchmark(nwords, repeats);
+    }
+    else
+    {
+        ok = benchmark(256, 200000);
+        ok = benchmark(4 * 1024 * 1024, 20) && ok;
+    }
+    return (ok ? 0 : 1);
+}
@@ -0,0 +1,58 @@
+#include <map>
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+#include <epicsTypes.h>
+#include <epicsMutex.h>
+
+#include "asynDriver.h"
+
+#include "daedataConfig.h"
+
+/// add nwords words starting at address to the transaction
+void DAEDataConfig::stage(unsigned address, const epicsUInt32* data, size_t nwords)
+{
+    for(size_t i=0; i<nwords; ++i)
+    {
+        m_words[address + 4 * (unsigned)i] = data[i];
+    }
+}
+
+/// the staged words as runs of consecutive addresses
+void DAEDataConfig::runs(std::vector<unsigned>& starts, std::vector< std::vector<epicsUInt32> >& data) const
+{
+    starts.clear();
+    data.clear();
+    for(std::map<unsigned, epicsUInt32>::const_iterator it = m_words.begin(); it != m_words.end(); ++it)
+    {
+        if (starts.empty() || it->first != starts.back() + 4 * (unsigned)data.back().size())
+        {
+            starts.push_back(it->first);
+            data.push_back(std::vector<epicsUInt32>());
+        }
+        data.back().push_back(it->second);
+    }
+}
+
+/// write all staged words, each run of consecutive addresses split into as few datagrams as the protocol 
+/// allows, then read everything back in one batch. The staged words are kept so the caller can update 
+/// its shadow memory, call clear() when done with them
+/// \param[out] mismatches words that did not verify, empty if the transaction succeeded
+/// \return number of write datagrams sent
+size_t DAEDataConfig::commit(DAEDataUDP* udp, asynUser* pasynUser, std::vector<DAEDataUDP::Mismatch>& mismatches)
+{
+    std::vector<unsigned> starts;
+    std::vector< std::vector<epicsUInt32> > data;
+    DAEDataUDP::DeferredVerify deferred;
+    size_t ndatagrams = 0;
+    runs(starts, data);
+    mismatches.clear();
+    for(size_t i=0; i<starts.size(); ++i)
+    {
+        udp->writeData(starts[i], &(data[i][0]), data[i].size(), true, pasynUser, &deferred);
+        ndatagrams += (data[i].size() + MAX_BLOCK_SIZE - 1) / MAX_BLOCK_SIZE;
+    }
+    udp->verifyDeferred(deferred, pasynUser, &mismatches);
+    return ndatagrams;
+}
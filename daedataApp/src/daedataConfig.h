@@ -0,0 +1,28 @@
+#ifndef DAEDATACONFIG_H
+#define DAEDATACONFIG_H
+
+#include <map>
+#include <vector>
+
+#include <epicsTypes.h>
+
+#include "daedataUDP.h"
+
+/// A set of register writes, e.g. a whole front end setup, staged and then uploaded to the DAE 
+/// as one transaction: coalesced into as few datagrams as possible, sent back to back and 
+/// verified together at the end. Not thread safe, the owning driver serialises access with its own lock
+class DAEDataConfig
+{
+public:
+    void stage(unsigned address, const epicsUInt32* data, size_t nwords);
+    void clear() { m_words.clear(); }
+    bool empty() const { return m_words.empty(); }
+    size_t size() const { return m_words.size(); }
+    size_t commit(DAEDataUDP* udp, asynUser* pasynUser, std::vector<DAEDataUDP::Mismatch>& mismatches);
+    void runs(std::vector<unsigned>& starts, std::vector< std::vector<epicsUInt32> >& data) const;
+
+private:
+    std::map<unsigned, epicsUInt32> m_words;  ///< staged value of each word address, a later stage() of the same address wins
+};
+
+#endif /* DAEDATACONFIG_H */
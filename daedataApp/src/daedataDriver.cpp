@@ -3,10 +3,14 @@
 #include <stdio.h>
 #include <errno.h>
 #include <math.h>
+#include <time.h>
 #include <exception>
 #include <stdexcept>
 #include <iostream>
+#include <sstream>
 #include <stdint.h>
+#include <ctype.h>
+#include <algorithm>
 
 #include <epicsTypes.h>
 #include <epicsTime.h>
@@ -16,10 +20,15 @@
 #include <epicsMutex.h>
 #include <epicsEvent.h>
 #include <iocsh.h>
+#include <dbAccess.h>
 
 #include "daedataDriver.h"
 #include "convertToString.h"
 #include "daedataUDP.h"
+#include "daedataKernels.h"
+#include "daedataAddress.h"
+#include "daedataConfig.h"
+#include "daedataError.h"
 
 #include <macLib.h>
 #include <epicsGuard.h>
@@ -30,30 +39,147 @@ static epicsThreadOnceId onceId = EPICS_THREAD_ONCE_INIT;
 
 static const char *driverName="daedataDriver";
 
+static const int DEFAULT_SCAN_GAP = 8;  ///< words
+
+static const int DUMP_RETRIES = 3;  ///< times a dump chunk is retried after e.g. a timeout before the dump stops
+
+static const double LINK_UPDATE_PERIOD = 1.0;  ///< seconds between posts of the LINK_* parameters by each board's poller
+
+/// read DAE memory for a record, from shadow memory if the drvInfo has an "age=" (seconds) modifier
+/// and the shadow copy is young enough. Called with the driver locked
+void daedataDriver::readMemory(asynUser *pasynUser, int board, const DAEDataAddress& addr, epicsUInt32* data, size_t nwords)
+{
+	Board& b = *m_boards[board];
+	epicsTime now = epicsTime::getCurrent();
+	if (addr.max_age > 0.0 && b.shadow.get(addr.address, data, nwords, addr.max_age, now))
+	{
+		asynPrint(pasynUser, ASYN_TRACE_FLOW, "%s:readMemory: board %d address 0x%x from shadow memory\n", driverName, board, addr.address);
+	}
+	else
+	{
+		b.udp->readData(addr.address, data, nwords, pasynUser, DAEDataUDP::InteractiveChannel);
+		b.shadow.update(addr.address, data, nwords, epicsTime::getCurrent());
+	}
+	if (addr.max_age > 0.0)
+	{
+		setIntegerParam(board, P_CacheHits, b.shadow.hits());
+		setIntegerParam(board, P_CacheMisses, b.shadow.misses());
+		setIntegerParam(board, P_CacheAge, (int)(1000.0 * b.shadow.meanHitAge()));
+	}
+	setIntegerParam(board, P_CacheWords, (int)b.shadow.size());
+}
+
+/// write DAE memory for a record, keeping shadow memory up to date if the write was verified. Called with the driver locked
+void daedataDriver::writeMemory(asynUser *pasynUser, int board, const DAEDataAddress& addr, const epicsUInt32* data, size_t nwords)
+{
+	Board& b = *m_boards[board];
+	b.udp->writeData(addr.address, data, nwords, addr.verify, pasynUser);
+	if (addr.verify)
+	{
+		b.shadow.update(addr.address, data, nwords, epicsTime::getCurrent());
+	}
+	else
+	{
+		b.shadow.invalidate(addr.address, nwords);
+	}
+	setIntegerParam(board, P_CacheWords, (int)b.shadow.size());
+}
+
+/// the span of words [first, last] a field has parts in
+static void fieldSpan(const DAEDataRegisterMap::Field& field, size_t& first, size_t& last)
+{
+	first = last = field.parts[0].word;
+	for(size_t i=1; i<field.parts.size(); ++i)
+	{
+		first = std::min(first, field.parts[i].word);
+		last = std::max(last, field.parts[i].word);
+	}
+}
+
+/// read the "bits=" field of an address, from shadow memory if allowed as readMemory(). Called with the driver locked
+epicsUInt32 daedataDriver::readField(asynUser *pasynUser, int board, const DAEDataAddress& addr)
+{
+	size_t first, last;
+	fieldSpan(addr.field, first, last);
+	std::vector<epicsUInt32> words(last + 1);
+	DAEDataAddress span(addr);
+	span.address += 4 * (unsigned)first;
+	readMemory(pasynUser, board, span, &(words[first]), last + 1 - first);
+	return DAEDataRegisterMap::extract(addr.field, &(words[0]));
+}
+
+/// change the bits in mask of a field of the block at base to those of value, with a read-modify-write of just the words 
+/// it lies in (see DAEDataUDP::writeMasked()), keeping shadow memory up to date as writeMemory(). Called with the driver locked
+/// \param[out] words the words of the block up to the field's last, those of the field as now written
+void daedataDriver::writeField(asynUser *pasynUser, int board, unsigned base, const DAEDataRegisterMap::Field& field, epicsUInt32 value, epicsUInt32 mask, bool verify, std::vector<epicsUInt32>& words)
+{
+	Board& b = *m_boards[board];
+	size_t first, last;
+	fieldSpan(field, first, last);
+	words.assign(last + 1, 0);
+	std::vector<epicsUInt32> masks(last + 1, 0);
+	DAEDataRegisterMap::insert(field, value, mask, &(words[0]), &(masks[0]));
+	unsigned address = base + 4 * (unsigned)first;
+	size_t nwords = last + 1 - first;
+	size_t nwritten = b.udp->writeMasked(address, &(words[first]), &(masks[first]), nwords, verify, pasynUser, &(words[first]));
+	if (verify)
+	{
+		b.shadow.update(address, &(words[first]), nwords, epicsTime::getCurrent());
+	}
+	else
+	{
+		b.shadow.invalidate(address, nwords);
+	}
+	setIntegerParam(board, P_CacheWords, (int)b.shadow.size());
+	asynPrint(pasynUser, ASYN_TRACE_FLOW, "%s:writeField: board %d address 0x%x %s mask 0x%x, %u of %u words changed\n", 
+	          driverName, board, address, field.name.c_str(), mask, (unsigned)nwritten, (unsigned)nwords);
+}
+
+/// whether a record's parameter is a bit field, of a register map or a "bits=" address, rather than whole words
+bool daedataDriver::isFieldParam(asynUser *pasynUser) const
+{
+	return m_register_params.count(pasynUser->reason) > 0 || 
+	       (isAddressParam(pasynUser->reason) && !((const DAEDataAddress*)pasynUser->userData)->field.parts.empty());
+}
+
+/// the board a record talks to, from its asyn address
+int daedataDriver::boardIndex(asynUser *pasynUser)
+{
+	int board = 0;
+	if (getAddress(pasynUser, &board) != asynSuccess || board < 0 || board >= (int)m_boards.size())
+	{
+		throw std::runtime_error("invalid asyn address, no such board");
+	}
+	return board;
+}
+
 template<typename T>
 asynStatus daedataDriver::writeValue(asynUser *pasynUser, const char* functionName, T value)
 {
     int function = pasynUser->reason;
     asynStatus status = asynSuccess;
     const char *paramName = NULL;
-	unsigned address;
 	getParamName(function, &paramName);
 	try
 	{
-		if (function == P_Address)
+		if (isAddressParam(function))
 		{
-			address = strtoul((const char*)pasynUser->userData, NULL, 0);
-			m_udp->writeData(address, &value, 1, true, pasynUser);
-			setIntegerParam(P_AddressW, address);
+			int board = boardIndex(pasynUser);
+			const DAEDataAddress* addr = (const DAEDataAddress*)pasynUser->userData;
+			writeMemory(pasynUser, board, *addr, &value, 1);
+			setIntegerParam(board, P_AddressW, addr->address);
+			callParamCallbacks(board);
 		}
 		else
 		{
 			throw std::runtime_error("invalid parameter");
 		}
-		callParamCallbacks();
-        asynPrint(pasynUser, ASYN_TRACEIO_DRIVER, 
-              "%s:%s: function=%d, name=%s, value=%s\n", 
-              driverName, functionName, function, paramName, convertToString(value).c_str());
+		if (daedataTraceOn(pasynUser, ASYN_TRACEIO_DRIVER))
+		{
+			asynPrint(pasynUser, ASYN_TRACEIO_DRIVER, 
+			      "%s:%s: function=%d, name=%s, value=%s\n", 
+			      driverName, functionName, function, paramName, convertToString(value).c_str());
+		}
 		return asynSuccess;
 	}
 	catch(const std::exception& ex)
@@ -69,26 +195,29 @@ template<typename T>
 asynStatus daedataDriver::readValue(asynUser *pasynUser, const char* functionName, T* value)
 {
 	int function = pasynUser->reason;
-	unsigned address;
     asynStatus status = asynSuccess;
     const char *paramName = NULL;
 	getParamName(function, &paramName);
 	try
 	{
-		if (function == P_Address)
+		if (isAddressParam(function))
 		{
-			address = strtoul((const char*)pasynUser->userData, NULL, 0);
-			m_udp->readData(address, value, 1, pasynUser);
-			setIntegerParam(P_AddressR, address);
+			int board = boardIndex(pasynUser);
+			const DAEDataAddress* addr = (const DAEDataAddress*)pasynUser->userData;
+			readMemory(pasynUser, board, *addr, value, 1);
+			setIntegerParam(board, P_AddressR, addr->address);
+			callParamCallbacks(board);
 		}
 		else
 		{
 			throw std::runtime_error("invalid parameter");
 		}
-		callParamCallbacks();
-        asynPrint(pasynUser, ASYN_TRACEIO_DRIVER, 
-              "%s:%s: function=%d, name=%s, value=%s\n", 
-              driverName, functionName, function, paramName, convertToString(*value).c_str());
+		if (daedataTraceOn(pasynUser, ASYN_TRACEIO_DRIVER))
+		{
+			asynPrint(pasynUser, ASYN_TRACEIO_DRIVER, 
+			      "%s:%s: function=%d, name=%s, value=%s\n", 
+			      driverName, functionName, function, paramName, convertToString(*value).c_str());
+		}
 		return asynSuccess;
 	}
 	catch(const std::exception& ex)
@@ -106,22 +235,26 @@ asynStatus daedataDriver::writeArray(asynUser *pasynUser, const char* functionNa
   int function = pasynUser->reason;
   asynStatus status = asynSuccess;
   const char *paramName = NULL;
-	unsigned address;
 	getParamName(function, &paramName);
 
 	try
 	{
-		if (function == P_Address)
+		if (isAddressParam(function))
 		{
-			address = strtoul((const char*)pasynUser->userData, NULL, 0);
-			m_udp->writeData(address, value, nElements, true, pasynUser);
-			setIntegerParam(P_AddressW, address);
+			int board = boardIndex(pasynUser);
+			const DAEDataAddress* addr = (const DAEDataAddress*)pasynUser->userData;
+			if (addr->nwords > 0 && addr->nwords < nElements)
+			{
+				nElements = addr->nwords;   // as readArray(), never past the words the drvInfo gives
+			}
+			writeMemory(pasynUser, board, *addr, value, nElements);
+			setIntegerParam(board, P_AddressW, addr->address);
+			callParamCallbacks(board);
 		}
 		else
 		{
 			throw std::runtime_error("invalid parameter");
 		}
-		callParamCallbacks();
         asynPrint(pasynUser, ASYN_TRACEIO_DRIVER, 
               "%s:%s: function=%d, name=%s\n", 
               driverName, functionName, function, paramName);
@@ -141,23 +274,27 @@ asynStatus daedataDriver::readArray(asynUser *pasynUser, const char* functionNam
 {
   int function = pasynUser->reason;
   asynStatus status = asynSuccess;
-   unsigned address;
   const char *paramName = NULL;
 	getParamName(function, &paramName);
 
 	try
 	{
-		if (function == P_Address)
+		if (isAddressParam(function))
 		{
-			address = strtoul((const char*)pasynUser->userData, NULL, 0);
-			m_udp->readData(address, value, nElements, pasynUser);
-			setIntegerParam(P_AddressR, address);
+			int board = boardIndex(pasynUser);
+			const DAEDataAddress* addr = (const DAEDataAddress*)pasynUser->userData;
+			if (addr->nwords > 0 && addr->nwords < nElements)
+			{
+				nElements = addr->nwords;
+			}
+			readMemory(pasynUser, board, *addr, value, nElements);
+			setIntegerParam(board, P_AddressR, addr->address);
+			callParamCallbacks(board);
 		}
 		else
 		{
 			throw std::runtime_error("invalid parameter");
 		}
-		callParamCallbacks();
 		*nIn = nElements;
         asynPrint(pasynUser, ASYN_TRACEIO_DRIVER, 
               "%s:%s: function=%d, name=%s\n", 
@@ -174,220 +311,1945 @@ asynStatus daedataDriver::readArray(asynUser *pasynUser, const char* functionNam
 	}
 }
 
+/// read the bits in mask of a register map field (as last decoded by the poller), a "bits=" address field or a word
+asynStatus daedataDriver::readBits(asynUser *pasynUser, const char* functionName, epicsUInt32* value, epicsUInt32 mask)
+{
+	int function = pasynUser->reason;
+	const char *paramName = NULL;
+	getParamName(function, &paramName);
+	try
+	{
+		if (m_register_params.count(function) > 0)
+		{
+			epicsInt32 field = 0;
+			int board = boardIndex(pasynUser);
+			asynStatus status = getIntegerParam(board, function, &field);
+			if (status != asynSuccess)
+			{
+				return status;
+			}
+			*value = (epicsUInt32)field & mask;
+			return asynSuccess;
+		}
+		else if (isAddressParam(function))
+		{
+			int board = boardIndex(pasynUser);
+			const DAEDataAddress* addr = (const DAEDataAddress*)pasynUser->userData;
+			if (addr->field.parts.empty())
+			{
+				readMemory(pasynUser, board, *addr, value, 1);
+			}
+			else
+			{
+				*value = readField(pasynUser, board, *addr);
+			}
+			*value &= mask;
+			setIntegerParam(board, P_AddressR, addr->address);
+			callParamCallbacks(board);
+		}
+		else
+		{
+			throw std::runtime_error("invalid parameter");
+		}
+		asynPrint(pasynUser, ASYN_TRACEIO_DRIVER, 
+		      "%s:%s: function=%d, name=%s, value=0x%x, mask=0x%x\n", 
+		      driverName, functionName, function, paramName, *value, mask);
+		return asynSuccess;
+	}
+	catch(const std::exception& ex)
+	{
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize, 
+                  "%s:%s: function=%d, name=%s, mask=0x%x, error=%s", 
+                  driverName, functionName, function, paramName, mask, ex.what());
+		return asynError;
+	}
+}
+
+/// change the bits in mask of a register map field, a "bits=" address field or a word, leaving the rest of the
+/// memory as it is in the DAE at the time. Register map fields are decoded again from the words written.
+/// \param whole value is the whole field, as from writeInt32(), and must fit in it
+asynStatus daedataDriver::writeBits(asynUser *pasynUser, const char* functionName, epicsUInt32 value, epicsUInt32 mask, bool whole)
+{
+	int function = pasynUser->reason;
+	const char *paramName = NULL;
+	getParamName(function, &paramName);
+	try
+	{
+		int board = boardIndex(pasynUser);
+		const DAEDataRegisterMap::Field* field = NULL;
+		RegisterBlock* rb = NULL;
+		size_t index = 0;
+		const DAEDataAddress* addr = NULL;
+		if (m_register_params.count(function) > 0)
+		{
+			if ( (rb = findRegisterField(board, function, index)) == NULL )
+			{
+				throw std::runtime_error("no register map for this board");
+			}
+			field = &(rb->map.fields()[index]);
+		}
+		else if (isAddressParam(function))
+		{
+			addr = (const DAEDataAddress*)pasynUser->userData;
+			field = (addr->field.parts.empty() ? &m_word_field : &(addr->field));
+		}
+		else
+		{
+			throw std::runtime_error("invalid parameter");
+		}
+		if (whole && field->width < 32 && (value >> field->width) != 0)
+		{
+			std::ostringstream error_message;
+			error_message << "value " << value << " does not fit in a " << field->width << " bit field";
+			throw std::runtime_error(error_message.str());
+		}
+		std::vector<epicsUInt32> words;
+		if (rb != NULL)
+		{
+			writeField(pasynUser, board, rb->base, *field, value, mask, true, words);
+			if (rb->decoded)
+			{
+				size_t first, last;
+				fieldSpan(*field, first, last);
+				std::vector<epicsUInt32> block(rb->words);
+				std::copy(words.begin() + first, words.end(), block.begin() + first);
+				decodeBlock(board, *rb, &(block[0]));
+			}
+			else
+			{
+				setIntegerParam(board, function, (epicsInt32)DAEDataRegisterMap::extract(*field, &(words[0])));
+			}
+		}
+		else
+		{
+			writeField(pasynUser, board, addr->address, *field, value, mask, addr->verify, words);
+			setIntegerParam(board, P_AddressW, addr->address);
+		}
+		callParamCallbacks(board);
+		asynPrint(pasynUser, ASYN_TRACEIO_DRIVER, 
+		      "%s:%s: function=%d, name=%s, value=0x%x, mask=0x%x\n", 
+		      driverName, functionName, function, paramName, value, mask);
+		return asynSuccess;
+	}
+	catch(const std::exception& ex)
+	{
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize, 
+                  "%s:%s: function=%d, name=%s, value=0x%x, mask=0x%x, error=%s", 
+                  driverName, functionName, function, paramName, value, mask, ex.what());
+		return asynError;
+	}
+}
+
+/// asynUInt32Digital is for masked writes (and polled reads) of fields and addresses, the driver makes no
+/// asynUInt32Digital callbacks, so I/O Intr and readback of fields go through asynInt32 instead
+asynStatus daedataDriver::writeUInt32Digital(asynUser *pasynUser, epicsUInt32 value, epicsUInt32 mask)
+{
+	return writeBits(pasynUser, "writeUInt32Digital", value, mask, false);
+}
+
+asynStatus daedataDriver::readUInt32Digital(asynUser *pasynUser, epicsUInt32 *value, epicsUInt32 mask)
+{
+	return readBits(pasynUser, "readUInt32Digital", value, mask);
+}
+
 asynStatus daedataDriver::writeInt32(asynUser *pasynUser, epicsInt32 value)
 {
+	if (pasynUser->reason == P_Dump)
+	{
+		int board = 0;
+		if (getAddress(pasynUser, &board) != asynSuccess)
+		{
+			return asynError;
+		}
+		if (m_dump_running)
+		{
+			epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize, "%s:writeInt32: a dump is already running", driverName);
+			return asynError;
+		}
+		m_dump_running = true;
+		m_dump_board = board;
+		setIntegerParam(board, P_DumpStatus, DumpRunning);
+		callParamCallbacks(board);
+		if (epicsThreadCreate("daedataDump", epicsThreadPriorityLow, epicsThreadGetStackSize(epicsThreadStackMedium), 
+		                      (EPICSTHREADFUNC)dumpThreadC, this) == 0)
+		{
+			m_dump_running = false;
+			setIntegerParam(board, P_DumpStatus, DumpFailed);
+			callParamCallbacks(board);
+			epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize, "%s:writeInt32: epicsThreadCreate failure", driverName);
+			return asynError;
+		}
+		return asynSuccess;
+	}
+	if (pasynUser->reason == P_DumpStart || pasynUser->reason == P_DumpWords)
+	{
+		return asynPortDriver::writeInt32(pasynUser, value);
+	}
+	if (isFieldParam(pasynUser))
+	{
+		return writeBits(pasynUser, "writeInt32", (epicsUInt32)value, 0xffffffff, true);
+	}
 	return writeValue(pasynUser, "writeInt32", (epicsUInt32)value);
 }
 
 asynStatus daedataDriver::readInt32(asynUser *pasynUser, epicsInt32 *value)
 {
+	if (isFieldParam(pasynUser))
+	{
+		return readBits(pasynUser, "readInt32", (epicsUInt32*)value, 0xffffffff);
+	}
 	return readValue(pasynUser, "readInt32", (epicsUInt32*)value);
 }
 
 asynStatus daedataDriver::readInt32Array(asynUser *pasynUser, epicsInt32 *value, size_t nElements, size_t *nIn)
 {
+	if (pasynUser->reason == P_ConfigDiff)
+	{
+		*nIn = std::min(nElements, m_config_diff.size());
+		std::copy(m_config_diff.begin(), m_config_diff.begin() + *nIn, value);
+		return asynSuccess;
+	}
     return readArray(pasynUser, "readInt32Array", (epicsUInt32*)value, nElements, nIn);
 }
 
 asynStatus daedataDriver::writeInt32Array(asynUser *pasynUser, epicsInt32 *value, size_t nElements)
 {
+	if (pasynUser->reason == P_ConfigUpload)
+	{
+		return uploadConfig(pasynUser, (const epicsUInt32*)value, nElements);
+	}
     return writeArray(pasynUser, "writeInt32Array", (epicsUInt32*)value, nElements);
 }
 
-asynStatus daedataDriver::readInt16Array(asynUser *pasynUser, epicsInt16 *value, size_t nElements, size_t *nIn)
+/// configuration transaction from a waveform record, value is a sequence of (address, nwords, word0, word1, ...)
+asynStatus daedataDriver::uploadConfig(asynUser *pasynUser, const epicsUInt32* value, size_t nElements)
 {
-  static const char* functionName = "readInt16Array";
-  int function = pasynUser->reason;
-  const char *paramName = NULL;
-  asynStatus status;
-	getParamName(function, &paramName);
-	*nIn = 0;
-	if (nElements % 2 == 0)
+	static const char* functionName = "uploadConfig";
+	m_config.clear();
+	if (getAddress(pasynUser, &m_config_board) != asynSuccess)
 	{
-		size_t nIn32 = 0;
-		epicsInt32* tmpval = new epicsInt32[nElements / 2];
-		if ( (status = readArray(pasynUser, functionName, (epicsUInt32*)tmpval, nElements / 2, &nIn32)) == asynSuccess )
-		{
-//			for(int i=0, j =0; i<nIn32; ++i, j += 2)
-//			{
-//		        value[j] = (tmpval[i] >> 16) & 0xffff;
-//		        value[j+1] = tmpval[i] & 0xffff;
-//			}
-			memcpy(value, tmpval, nIn32 * sizeof(epicsInt32));
-		    *nIn = nIn32 * 2;
-		}
-		delete[] tmpval;
-		return status;
+		return asynError;
 	}
-	else
+	for(size_t i=0; i<nElements; )
 	{
-        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize, 
-                  "%s:%s: function=%d, name=%s, error=%s", 
-                  driverName, functionName, function, paramName, "nElements must be even");
-		return asynError;		
+		if (nElements - i < 2 || value[i+1] == 0 || value[i+1] > nElements - i - 2 || value[i] % 4 != 0)
+		{
+			m_config.clear();
+			epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize, 
+                  "%s:%s: malformed upload at element %u", driverName, functionName, (unsigned)i);
+			return asynError;
+		}
+		m_config.stage(value[i], value + i + 2, value[i+1]);
+		i += 2 + value[i+1];
 	}
+	return commitConfig(pasynUser);
 }
 
-asynStatus daedataDriver::writeInt16Array(asynUser *pasynUser, epicsInt16 *value, size_t nElements)
+/// send the staged configuration transaction, verify it and publish the result. Called with the driver locked
+asynStatus daedataDriver::commitConfig(asynUser *pasynUser)
 {
-  static const char* functionName = "writeInt16Array";
-  int function = pasynUser->reason;
-  const char *paramName = NULL;
-  asynStatus status;
-	getParamName(function, &paramName);
-	if (nElements % 2 == 0)
+	static const char* functionName = "commitConfig";
+	std::vector<DAEDataUDP::Mismatch> mismatches;
+	std::vector<unsigned> starts;
+	std::vector< std::vector<epicsUInt32> > data;
+	asynStatus status = asynSuccess;
+	int board = m_config_board;
+	Board& b = *m_boards[board];
+	m_config.runs(starts, data);
+	try
 	{
-		size_t nOut32 = nElements / 2;
-		epicsInt32* tmpval = new epicsInt32[nOut32];
-		memcpy(tmpval, value, nOut32 * sizeof(epicsInt32));
-		status = writeArray(pasynUser, functionName, (epicsUInt32*)tmpval, nOut32);
-		delete[] tmpval;
-		return status;
+		size_t ndatagrams = m_config.commit(b.udp, pasynUser, mismatches);
+		epicsTime now = epicsTime::getCurrent();
+		for(size_t i=0; i<starts.size(); ++i)
+		{
+			b.shadow.update(starts[i], &(data[i][0]), data[i].size(), now);
+		}
+		m_config_diff.clear();
+		for(size_t i=0; i<mismatches.size(); ++i)
+		{
+			b.shadow.update(mismatches[i].address, &(mismatches[i].actual), 1, now);
+			m_config_diff.push_back(mismatches[i].address);
+			m_config_diff.push_back(mismatches[i].expected);
+			m_config_diff.push_back(mismatches[i].actual);
+		}
+		setIntegerParam(board, P_ConfigStatus, mismatches.empty() ? ConfigOK : ConfigVerifyFailed);
+		setIntegerParam(board, P_ConfigDatagrams, (int)ndatagrams);
+		if (!mismatches.empty())
+		{
+			epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize, 
+                  "%s:%s: %u words failed verify, first at address 0x%x", driverName, functionName, 
+				  (unsigned)mismatches.size(), mismatches[0].address);
+			status = asynError;
+		}
 	}
-	else
+	catch(const std::exception& ex)
 	{
+		for(size_t i=0; i<starts.size(); ++i)
+		{
+			b.shadow.invalidate(starts[i], data[i].size());
+		}
+		m_config_diff.clear();
+		setIntegerParam(board, P_ConfigStatus, ConfigError);
+		setIntegerParam(board, P_ConfigDatagrams, 0);
         epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize, 
-                  "%s:%s: function=%d, name=%s, error=%s", 
-                  driverName, functionName, function, paramName, "nElements must be even");
-		return asynError;		
+                  "%s:%s: %s", driverName, functionName, ex.what());
+		status = asynError;
 	}
+	m_config.clear();
+	setIntegerParam(board, P_ConfigMismatches, (int)mismatches.size());
+	setIntegerParam(board, P_CacheWords, (int)b.shadow.size());
+	doCallbacksInt32Array(m_config_diff.empty() ? NULL : &(m_config_diff[0]), m_config_diff.size(), P_ConfigDiff, board);
+	callParamCallbacks(board);
+	return status;
 }
 
-
-/// Constructor for the isisdaeDriver class.
-/// Calls constructor for the asynPortDriver base class.
-/// \param[in] dcomint DCOM interface pointer created by lvDCOMConfigure()
-/// \param[in] portName @copydoc initArg0
-daedataDriver::daedataDriver(const char *portName, const char* host, bool simulate) 
-   : asynPortDriver(portName, 
-                    1, /* maxAddr */ 
-                    NUM_ISISDAE_PARAMS,
-                    asynInt32Mask | asynInt32ArrayMask | asynInt16ArrayMask | asynDrvUserMask, /* Interface mask */
-                    asynInt32Mask | asynInt32ArrayMask | asynInt16ArrayMask,  /* Interrupt mask */
-                    ASYN_CANBLOCK , /* asynFlags.  This driver can block but it is not multi-device */
-                    1, /* Autoconnect */
-                    0, /* Default priority */
-                    0)	/* Default stack size*/					
+/// start a configuration transaction for a board from iocsh, discarding anything already staged
+void daedataDriver::configBegin(int board)
 {
-    const char *functionName = "daedataDriver";
-//	epicsThreadOnce(&onceId, initCOM, NULL);
+	lock();
+	m_config.clear();
+	m_config_board = board;
+	unlock();
+}
 
-	m_udp = new DAEDataUDP(host, simulate);
+/// add words to the configuration transaction from iocsh
+void daedataDriver::configStage(unsigned address, const epicsUInt32* data, size_t nwords)
+{
+	lock();
+	m_config.stage(address, data, nwords);
+	unlock();
+}
 
-	createParam(P_AddressString, asynParamInt32, &P_Address);
-	createParam(P_AddressWString, asynParamInt32, &P_AddressW);
-	createParam(P_AddressRString, asynParamInt32, &P_AddressR);
+/// commit the configuration transaction from iocsh, printing the per address differences if verify fails
+int daedataDriver::configCommit()
+{
+	lock();
+	size_t nwords = m_config.size();
+	asynStatus status = commitConfig(pasynUserSelf);
+	if (status == asynSuccess)
+	{
+		std::cout << "daedataConfigCommit: " << nwords << " words written and verified" << std::endl;
+	}
+	else
+	{
+		std::cerr << "daedataConfigCommit: " << pasynUserSelf->errorMessage << std::endl;
+		for(size_t i=0; i+2<m_config_diff.size(); i += 3)
+		{
+			fprintf(stderr, "    0x%08x: wrote 0x%08x read 0x%08x\n", (unsigned)m_config_diff[i], (unsigned)m_config_diff[i+1], (unsigned)m_config_diff[i+2]);
+		}
+	}
+	unlock();
+	return status;
+}
 
-    // Create the thread for background tasks (not used at present, could be used for I/O intr scanning) 
-    if (epicsThreadCreate("isisdaePoller",
-                          epicsThreadPriorityMedium,
-                          epicsThreadGetStackSize(epicsThreadStackMedium),
-                          (EPICSTHREADFUNC)pollerThreadC, this) == 0)
-    {
-        printf("%s:%s: epicsThreadCreate failure\n", driverName, functionName);
-        return;
-    }
+/// dump DAE memory to a file from iocsh, printing progress
+int daedataDriver::dump(int board, const char* filename, unsigned start, size_t nwords)
+{
+	lock();
+	if (m_dump_running)
+	{
+		unlock();
+		std::cerr << "daedataDump: a dump is already running" << std::endl;
+		return asynError;
+	}
+	m_dump_running = true;
+	m_dump_board = board;
+	unlock();
+	return runDump(filename, start, nwords, true);
 }
 
-void daedataDriver::pollerThreadC(void* arg)
+void daedataDriver::dumpThreadC(void* arg)
 { 
     daedataDriver* driver = (daedataDriver*)arg; 
-	driver->pollerThread();
+	driver->dumpThread();
 }
 
-void daedataDriver::pollerThread()
+/// dump started by writing to the DUMP parameter, the region comes from the DUMP_* parameters
+void daedataDriver::dumpThread()
 {
-    static const char* functionName = "isisdaePoller";
-	while(false)
+	char filename[256];
+	int start = 0, nwords = 0;
+	lock();
+	getStringParam(m_dump_board, P_DumpFile, sizeof(filename), filename);
+	getIntegerParam(m_dump_board, P_DumpStart, &start);
+	getIntegerParam(m_dump_board, P_DumpWords, &nwords);
+	unlock();
+	runDump(filename, start, nwords, false);
+}
+
+/// stream a region of DAE memory to a file, carrying on from where the last dump stopped if it 
+/// failed part way through the same region. Called without the driver lock and with m_dump_running set
+int daedataDriver::runDump(const std::string& filename, unsigned start, size_t nwords, bool print)
+{
+	asynStatus status = asynSuccess;
+	DumpProgress progress(this, print);
+	if (filename.empty() || nwords == 0 || start % 4 != 0)
+	{
+		asynPrint(pasynUserSelf, ASYN_TRACE_ERROR, "%s:runDump: need a file name, a word aligned start address and at least one word\n", driverName);
+		status = asynError;
+	}
+	else
 	{
 		lock();
-		callParamCallbacks();
+		bool resume = m_dump.prepare(filename, start, nwords);
+		setIntegerParam(m_dump_board, P_DumpStatus, DumpRunning);
+		setIntegerParam(m_dump_board, P_DumpDone, (int)m_dump.done());
+		callParamCallbacks(m_dump_board);
 		unlock();
-		epicsThreadSleep(1.0);
+		if (print && resume)
+		{
+			printf("daedataDump: resuming at address 0x%x\n", start + 4 * (unsigned)m_dump.done());
+		}
+		try
+		{
+			m_dump.run(m_boards[m_dump_board]->udp, pasynUserSelf, &progress, DUMP_RETRIES);
+		}
+		catch(const std::exception& ex)
+		{
+			asynPrint(pasynUserSelf, ASYN_TRACE_ERROR, "%s:runDump: %s\n", driverName, ex.what());
+			if (print)
+			{
+				std::cerr << "daedataDump: " << ex.what() << std::endl;
+			}
+			status = asynError;
+		}
 	}
-}	
+	if (print && status == asynSuccess)
+	{
+		printf("daedataDump: %u words from 0x%x written to %s at %.1f MB/s\n", (unsigned)nwords, start, filename.c_str(), m_dump.rate());
+	}
+	lock();
+	m_dump_running = false;
+	setIntegerParam(m_dump_board, P_DumpStatus, (status == asynSuccess ? DumpDone : DumpFailed));
+	callParamCallbacks(m_dump_board);
+	unlock();
+	return status;
+}
 
-asynStatus daedataDriver::drvUserCreate(asynUser *pasynUser, const char* drvInfo, const char** pptypeName, size_t* psize)
+/// add a range of a board's memory to its snapshots, in addition to its register map blocks
+void daedataDriver::addSnapshotRange(int board, unsigned start, size_t nwords)
 {
-   const char *functionName = "drvUserCreate";
-   if (strncmp(drvInfo, "0x", 2) == 0)
-   {
-       pasynUser->reason = P_Address;
-       pasynUser->userData = epicsStrDup(drvInfo);
-       asynPrint(pasynUser, ASYN_TRACE_FLOW,
-          "%s:%s: index=%d address=%s\n", 
-          driverName, functionName, pasynUser->reason, (const char*)pasynUser->userData);
-       return asynSuccess;
-   }
-   else
-   {
-       return asynPortDriver::drvUserCreate(pasynUser, drvInfo, pptypeName, psize);
-   }
+	lock();
+	m_boards[board]->snapshot_ranges.push_back(std::pair<unsigned, size_t>(start, nwords));
+	unlock();
 }
 
-asynStatus daedataDriver::drvUserDestroy(asynUser *pasynUser)
+/// set up a snapshot of the ranges added by addSnapshotRange() and the register map blocks of a board
+void daedataDriver::snapshotRanges(int board, DAEDataSnapshot& snap)
 {
-   const char *functionName = "drvUserDestroy";
-   if ( pasynUser->reason == P_Address  )
-   {
-      asynPrint(pasynUser, ASYN_TRACE_FLOW,
-          "%s:%s: index=%d address=%s\n", 
-          driverName, functionName, pasynUser->reason, (const char*)pasynUser->userData);
-      free(pasynUser->userData);
-      pasynUser->userData = NULL;
-      return asynSuccess;
-  }
-  else
-  {
-      return asynPortDriver::drvUserDestroy(pasynUser);
-  }
+	Board& b = *m_boards[board];
+	lock();
+	for(size_t i=0; i<b.snapshot_ranges.size(); ++i)
+	{
+		snap.addRange(b.snapshot_ranges[i].first, b.snapshot_ranges[i].second);
+	}
+	for(size_t i=0; i<b.register_blocks.size(); ++i)
+	{
+		snap.addRange(b.register_blocks[i].base, b.register_blocks[i].map.nwords());
+	}
+	unlock();
+	if (snap.ranges().empty())
+	{
+		throw std::runtime_error("nothing to snapshot, add ranges with daedataSnapshotRange() or load a register map");
+	}
 }
 
-extern "C" {
+/// print where a snapshot came from and whether the board's firmware matches it
+/// \return false if the firmware words differ
+bool daedataDriver::checkSnapshot(const char* func, int board, const DAEDataSnapshot& snap, const epicsUInt32* firmware)
+{
+	char taken[40];
+	time_t t = snap.taken();
+	strftime(taken, sizeof(taken), "%Y-%m-%d %H:%M:%S", localtime(&t));
+	printf("%s: snapshot of %s taken %s, %u words in %u ranges\n", func, snap.host().c_str(), taken, (unsigned)snap.nwords(), (unsigned)snap.ranges().size());
+	if (snap.host() != m_boards[board]->host)
+	{
+		printf("%s: note board %d is %s\n", func, board, m_boards[board]->host.c_str());
+	}
+	if (!std::equal(firmware, firmware + DAEDataSnapshot::FIRMWARE_WORDS, snap.firmware()))
+	{
+		fprintf(stderr, "%s: firmware differs:", func);
+		for(int i=0; i<DAEDataSnapshot::FIRMWARE_WORDS; ++i)
+		{
+			fprintf(stderr, " 0x%x: 0x%08x now 0x%08x", DAEDataSnapshot::FIRMWARE_ADDRESS + 4 * i, (unsigned)snap.firmware()[i], (unsigned)firmware[i]);
+		}
+		fprintf(stderr, "\n");
+		return false;
+	}
+	return true;
+}
 
-/// EPICS iocsh callable function to call constructor of lvDCOMInterface().
-/// \param[in] portName @copydoc initArg0
-/// \param[in] configSection @copydoc initArg1
-/// \param[in] configFile @copydoc initArg2
-/// \param[in] host @copydoc initArg3
-/// \param[in] options @copydoc initArg4
-/// \param[in] progid @copydoc initArg5
-/// \param[in] username @copydoc initArg6
-/// \param[in] password @copydoc initArg7
-int daedataConfigure(const char *portName, const char *host, int simulate)
+/// read a board's snapshot ranges and firmware words in one batch and save them to a file from iocsh
+int daedataDriver::snapshot(int board, const std::string& filename)
 {
 	try
 	{
-			new daedataDriver(portName, host, (simulate != 0));
-			return(asynSuccess);
+		DAEDataSnapshot snap;
+		snapshotRanges(board, snap);
+		epicsTime start = epicsTime::getCurrent();
+		snap.capture(m_boards[board]->udp, pasynUserSelf, m_boards[board]->host);
+		double elapsed = epicsTime::getCurrent() - start;
+		snap.save(filename);
+		printf("daedataSnapshot: %u words in %u ranges from %s read in %.3f s and written to %s\n", (unsigned)snap.nwords(), 
+		       (unsigned)snap.ranges().size(), m_boards[board]->host.c_str(), elapsed, filename.c_str());
+		return asynSuccess;
 	}
 	catch(const std::exception& ex)
 	{
-		std::cerr << "daedataConfigure failed: " << ex.what() << std::endl;
-		return(asynError);
+		std::cerr << "daedataSnapshot: " << ex.what() << std::endl;
+		return asynError;
 	}
 }
 
-// EPICS iocsh shell commands 
-
-static const iocshArg initArg0 = { "portName", iocshArgString};			///< The name of the asyn driver port we will create
-static const iocshArg initArg1 = { "host", iocshArgString};				///< host name where LabVIEW is running ("" for localhost) 
-static const iocshArg initArg2 = { "simulate", iocshArgInt};				///< host name where LabVIEW is running ("" for localhost) 
-
-static const iocshArg * const initArgs[] = { &initArg0,
-											 &initArg1,
-                                             &initArg2 };
+/// compare a snapshot file with a board from iocsh, printing the words that differ
+/// \return asynSuccess if the board matches the snapshot
+int daedataDriver::snapshotDiff(int board, const std::string& filename)
+{
+	static const size_t MAX_PRINT = 100;
+	try
+	{
+		DAEDataSnapshot snap;
+		snap.load(filename);
+		std::vector<DAEDataUDP::Mismatch> differences;
+		epicsUInt32 firmware[DAEDataSnapshot::FIRMWARE_WORDS];
+		snap.diff(m_boards[board]->udp, pasynUserSelf, differences, firmware);
+		bool same_firmware = checkSnapshot("daedataSnapshotDiff", board, snap, firmware);
+		for(size_t i=0; i<differences.size() && i<MAX_PRINT; ++i)
+		{
+			printf("    0x%08x: snapshot 0x%08x board 0x%08x\n", differences[i].address, (unsigned)differences[i].expected, (unsigned)differences[i].actual);
+		}
+		if (differences.size() > MAX_PRINT)
+		{
+			printf("    ... and %u more\n", (unsigned)(differences.size() - MAX_PRINT));
+		}
+		printf("daedataSnapshotDiff: %u of %u words differ\n", (unsigned)differences.size(), (unsigned)snap.nwords());
+		return (differences.empty() && same_firmware ? asynSuccess : asynError);
+	}
+	catch(const std::exception& ex)
+	{
+		std::cerr << "daedataSnapshotDiff: " << ex.what() << std::endl;
+		return asynError;
+	}
+}
+
+/// restore a board from a snapshot file from iocsh: compare the snapshot with the board in one batch of reads, then write back
+/// only the runs of words that differ, joined where that saves datagrams, and verify them in one batch as a configuration
+/// transaction. Refuses if the board's firmware is not that the snapshot was taken from, unless forced. The port is only
+/// locked for the commit and the shadow memory update, so a record writing a word after the diff has its value overwritten
+int daedataDriver::snapshotRestore(int board, const std::string& filename, bool force)
+{
+	Board& b = *m_boards[board];
+	DAEDataConfig config;
+	std::vector<DAEDataUDP::Mismatch> mismatches;
+	int status = asynSuccess;
+	try
+	{
+		// the load and the diff only read the file and the board, so leave the port to the records meanwhile
+		DAEDataSnapshot snap;
+		snap.load(filename);
+		epicsTime start = epicsTime::getCurrent();
+		std::vector<DAEDataUDP::Mismatch> differences;
+		epicsUInt32 firmware[DAEDataSnapshot::FIRMWARE_WORDS];
+		snap.diff(b.udp, pasynUserSelf, differences, firmware);
+		if (!checkSnapshot("daedataSnapshotRestore", board, snap, firmware) && !force)
+		{
+			throw std::runtime_error("not restoring a snapshot from other firmware, force to do so anyway");
+		}
+		size_t nstaged = snap.stageRestore(differences, config);
+		lock();
+		try
+		{
+			size_t ndatagrams = (config.empty() ? 0 : config.commit(b.udp, pasynUserSelf, mismatches));
+			double elapsed = epicsTime::getCurrent() - start;
+			std::vector<unsigned> starts;
+			std::vector< std::vector<epicsUInt32> > data;
+			config.runs(starts, data);
+			epicsTime now = epicsTime::getCurrent();
+			for(size_t i=0; i<starts.size(); ++i)
+			{
+				b.shadow.update(starts[i], &(data[i][0]), data[i].size(), now);
+			}
+			for(size_t i=0; i<mismatches.size(); ++i)
+			{
+				b.shadow.update(mismatches[i].address, &(mismatches[i].actual), 1, now);
+				fprintf(stderr, "    0x%08x: wrote 0x%08x read 0x%08x\n", mismatches[i].address, (unsigned)mismatches[i].expected, (unsigned)mismatches[i].actual);
+			}
+			printf("daedataSnapshotRestore: %u of %u words differed, %u written in %u datagrams in %.3f s, %u failed verify\n", (unsigned)differences.size(), 
+			       (unsigned)snap.nwords(), (unsigned)nstaged, (unsigned)ndatagrams, elapsed, (unsigned)mismatches.size());
+			status = (mismatches.empty() ? asynSuccess : asynError);
+		}
+		catch(const std::exception&)
+		{
+			// what a failed commit left in the staged words is unknown, so read them from the board next time
+			std::vector<unsigned> starts;
+			std::vector< std::vector<epicsUInt32> > data;
+			config.runs(starts, data);
+			for(size_t i=0; i<starts.size(); ++i)
+			{
+				b.shadow.invalidate(starts[i], data[i].size());
+			}
+			setIntegerParam(board, P_CacheWords, (int)b.shadow.size());
+			callParamCallbacks(board);
+			unlock();
+			throw;
+		}
+		setIntegerParam(board, P_CacheWords, (int)b.shadow.size());
+		callParamCallbacks(board);
+		unlock();
+	}
+	catch(const std::exception& ex)
+	{
+		std::cerr << "daedataSnapshotRestore: " << ex.what() << std::endl;
+		status = asynError;
+	}
+	return status;
+}
+
+void daedataDriver::DumpProgress::progress(size_t done, size_t total, double rate)
+{
+	m_driver->lock();
+	int board = m_driver->m_dump_board;
+	m_driver->setIntegerParam(board, m_driver->P_DumpDone, (int)done);
+	m_driver->setDoubleParam(board, m_driver->P_DumpRate, rate);
+	m_driver->callParamCallbacks(board);
+	m_driver->unlock();
+	int percent = (int)(100.0 * done / total);
+	if (m_print && percent / 10 != m_percent / 10)
+	{
+		printf("daedataDump: %d%% (%u of %u words) %.1f MB/s\n", percent, (unsigned)done, (unsigned)total, rate);
+		m_percent = percent;
+	}
+}
+
+/// how a record's 16 bit elements are laid out in DAE words, from the width= and order= drvInfo modifiers
+static DAEDataUDP::Format int16Format(const DAEDataAddress& addr)
+{
+	if (addr.width == 32)
+	{
+		return DAEDataUDP::Low16;
+	}
+	switch(addr.order)
+	{
+	case DAEDataAddress::HalfOrderHighFirst:
+		return DAEDataUDP::Halves16HighFirst;
+	case DAEDataAddress::HalfOrderLowFirst:
+		return DAEDataUDP::Halves16LowFirst;
+	default:
+		return DAEDataUDP::Halves16Native;
+	}
+}
+
+/// 16 bit reads are decoded by DAEDataUDP straight from the datagrams into the record's buffer, so 
+/// do not go through shadow memory (which holds whole words)
+asynStatus daedataDriver::readInt16Array(asynUser *pasynUser, epicsInt16 *value, size_t nElements, size_t *nIn)
+{
+  static const char* functionName = "readInt16Array";
+  int function = pasynUser->reason;
+  asynStatus status = asynSuccess;
+  const char *paramName = NULL;
+	getParamName(function, &paramName);
+	*nIn = 0;
+	try
+	{
+		if (!isAddressParam(function))
+		{
+			throw std::runtime_error("invalid parameter");
+		}
+		int board = boardIndex(pasynUser);
+		const DAEDataAddress* addr = (const DAEDataAddress*)pasynUser->userData;
+		DAEDataUDP::Format format = int16Format(*addr);
+		size_t per_word = (format == DAEDataUDP::Low16 ? 1 : 2);
+		if (nElements % per_word != 0)
+		{
+			throw std::runtime_error("nElements must be even");
+		}
+		size_t nwords = nElements / per_word;
+		if (addr->nwords > 0 && addr->nwords < nwords)
+		{
+			nwords = addr->nwords;
+		}
+		m_boards[board]->udp->readData(addr->address, value, nwords, format, (epicsUInt32)addr->offset, pasynUser, DAEDataUDP::InteractiveChannel);
+		setIntegerParam(board, P_AddressR, addr->address);
+		callParamCallbacks(board);
+		*nIn = nwords * per_word;
+        asynPrint(pasynUser, ASYN_TRACEIO_DRIVER, 
+              "%s:%s: function=%d, name=%s\n", 
+              driverName, functionName, function, paramName);
+		return asynSuccess;
+	}
+	catch(const std::exception& ex)
+	{
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize, 
+                  "%s:%s: status=%d, function=%d, name=%s, error=%s", 
+                  driverName, functionName, status, function, paramName, ex.what());
+		return asynError;
+	}
+}
+
+asynStatus daedataDriver::writeInt16Array(asynUser *pasynUser, epicsInt16 *value, size_t nElements)
+{
+  static const char* functionName = "writeInt16Array";
+  int function = pasynUser->reason;
+  asynStatus status = asynSuccess;
+  const char *paramName = NULL;
+	getParamName(function, &paramName);
+	try
+	{
+		if (!isAddressParam(function))
+		{
+			throw std::runtime_error("invalid parameter");
+		}
+		int board = boardIndex(pasynUser);
+		const DAEDataAddress* addr = (const DAEDataAddress*)pasynUser->userData;
+		DAEDataUDP::Format format = int16Format(*addr);
+		size_t per_word = (format == DAEDataUDP::Low16 ? 1 : 2);
+		if (nElements % per_word != 0)
+		{
+			throw std::runtime_error("nElements must be even");
+		}
+		size_t nwords = nElements / per_word;
+		if (addr->nwords > 0 && addr->nwords < nwords)
+		{
+			nwords = addr->nwords;
+		}
+		Board& b = *m_boards[board];
+		b.udp->writeData(addr->address, value, nwords, format, (epicsUInt32)addr->offset, addr->verify, pasynUser);
+		b.shadow.invalidate(addr->address, nwords);
+		setIntegerParam(board, P_CacheWords, (int)b.shadow.size());
+		setIntegerParam(board, P_AddressW, addr->address);
+		callParamCallbacks(board);
+        asynPrint(pasynUser, ASYN_TRACEIO_DRIVER, 
+              "%s:%s: function=%d, name=%s\n", 
+              driverName, functionName, function, paramName);
+		return asynSuccess;
+	}
+	catch(const std::exception& ex)
+	{
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize, 
+                  "%s:%s: status=%d, function=%d, name=%s, error=%s", 
+                  driverName, functionName, status, function, paramName, ex.what());
+		return asynError;
+	}
+}
+
+
+/// split the daedataConfigure() host argument, a comma separated list with one entry per board.
+/// Spaces and tabs around each entry are ignored
+static std::vector<std::string> splitHosts(const char* host)
+{
+	std::vector<std::string> hosts;
+	std::string h = (host != NULL ? host : "");
+	size_t pos = 0;
+	while(pos < h.size())
+	{
+		size_t end = h.find(',', pos);
+		if (end == std::string::npos)
+		{
+			end = h.size();
+		}
+		size_t first = h.find_first_not_of(" \t", pos);
+		if (first != std::string::npos && first < end)
+		{
+			size_t last = h.find_last_not_of(" \t", end - 1);
+			hosts.push_back(h.substr(first, last + 1 - first));
+		}
+		pos = end + 1;
+	}
+	if (hosts.empty())
+	{
+		hosts.push_back(h);
+	}
+	return hosts;
+}
+
+/// Constructor for the isisdaeDriver class.
+/// Calls constructor for the asynPortDriver base class.
+/// \param[in] dcomint DCOM interface pointer created by lvDCOMConfigure()
+/// \param[in] portName @copydoc initArg0
+daedataDriver::daedataDriver(const char *portName, const char* host, bool simulate, int options, int window, double timeout, int retries) 
+   : asynPortDriver(portName, 
+                    (int)splitHosts(host).size(), /* maxAddr, one per board */ 
+                    NUM_ISISDAE_PARAMS + MAX_ADDRESS_PARAMS,
+                    asynInt32Mask | asynUInt32DigitalMask | asynInt32ArrayMask | asynInt16ArrayMask | asynFloat64Mask | asynFloat64ArrayMask | asynOctetMask | asynDrvUserMask, /* Interface mask */
+                    asynInt32Mask | asynInt32ArrayMask | asynFloat64Mask | asynFloat64ArrayMask,  /* Interrupt mask, not asynUInt32Digital: masked reads and writes only, fields post as asynInt32; 
+                                                                                  not asynInt16Array: polled values post as 32 bit words, so a 16 bit I/O Intr record fails at iocInit */
+                    ASYN_CANBLOCK | (splitHosts(host).size() > 1 ? ASYN_MULTIDEVICE : 0), /* asynFlags.  This driver can block, and is multi-device (asyn address = board) if given several hosts */
+                    1, /* Autoconnect */
+                    0, /* Default priority */
+                    0),	/* Default stack size*/					
+	m_scan_gap(DEFAULT_SCAN_GAP), m_config_board(0), m_dump_running(false), m_dump_board(0)
+{
+    const char *functionName = "daedataDriver";
+//	epicsThreadOnce(&onceId, initCOM, NULL);
+
+	m_word_field.name = "word";
+	m_word_field.width = 0;
+	DAEDataRegisterMap::addPart(m_word_field, 0, 0, 32);
+
+	std::vector<std::string> hosts = splitHosts(host);
+	for(size_t i=0; i<hosts.size(); ++i)
+	{
+		m_boards.push_back(new Board(hosts[i], new DAEDataUDP(hosts[i].c_str(), simulate, options, (window > 0 ? window : 0), timeout, (retries > 0 ? retries : -1))));
+	}
+
+	createParam(P_AddressString, asynParamInt32, &P_Address);
+	createParam(P_AddressWString, asynParamInt32, &P_AddressW);
+	createParam(P_AddressRString, asynParamInt32, &P_AddressR);
+	createParam(P_CacheHitsString, asynParamInt32, &P_CacheHits);
+	createParam(P_CacheMissesString, asynParamInt32, &P_CacheMisses);
+	createParam(P_CacheAgeString, asynParamInt32, &P_CacheAge);
+	createParam(P_CacheWordsString, asynParamInt32, &P_CacheWords);
+	createParam(P_ConfigUploadString, asynParamInt32Array, &P_ConfigUpload);
+	createParam(P_ConfigStatusString, asynParamInt32, &P_ConfigStatus);
+	createParam(P_ConfigMismatchesString, asynParamInt32, &P_ConfigMismatches);
+	createParam(P_ConfigDatagramsString, asynParamInt32, &P_ConfigDatagrams);
+	createParam(P_ConfigDiffString, asynParamInt32Array, &P_ConfigDiff);
+	createParam(P_DumpFileString, asynParamOctet, &P_DumpFile);
+	createParam(P_DumpStartString, asynParamInt32, &P_DumpStart);
+	createParam(P_DumpWordsString, asynParamInt32, &P_DumpWords);
+	createParam(P_DumpString, asynParamInt32, &P_Dump);
+	createParam(P_DumpStatusString, asynParamInt32, &P_DumpStatus);
+	createParam(P_DumpDoneString, asynParamInt32, &P_DumpDone);
+	createParam(P_DumpRateString, asynParamFloat64, &P_DumpRate);
+	createParam(P_LinkReadsString, asynParamFloat64, &P_LinkReads);
+	createParam(P_LinkReadBytesString, asynParamFloat64, &P_LinkReadBytes);
+	createParam(P_LinkRetransmitsString, asynParamFloat64, &P_LinkRetransmits);
+	createParam(P_LinkTimeoutsString, asynParamFloat64, &P_LinkTimeouts);
+	createParam(P_LinkStaleString, asynParamFloat64, &P_LinkStale);
+	createParam(P_LinkSizeErrorsString, asynParamFloat64, &P_LinkSizeErrors);
+	createParam(P_LinkWritesString, asynParamFloat64, &P_LinkWrites);
+	createParam(P_LinkWriteBytesString, asynParamFloat64, &P_LinkWriteBytes);
+	createParam(P_LinkSendErrorsString, asynParamFloat64, &P_LinkSendErrors);
+	createParam(P_LinkVerifyRereadsString, asynParamFloat64, &P_LinkVerifyRereads);
+	createParam(P_LinkVerifyFailuresString, asynParamFloat64, &P_LinkVerifyFailures);
+	createParam(P_LinkRTTHistString, asynParamFloat64Array, &P_LinkRTTHist);
+	createParam(P_LinkRTTLimitsString, asynParamFloat64Array, &P_LinkRTTLimits);
+	createParam(P_LinkRTTString, asynParamFloat64, &P_LinkRTT);
+	createParam(P_LinkRTOString, asynParamFloat64, &P_LinkRTO);
+	createParam(P_LinkUpString, asynParamInt32, &P_LinkUp);
+	createParam(P_LinkRejectedString, asynParamFloat64, &P_LinkRejected);
+	createParam(P_PollPostedString, asynParamFloat64, &P_PollPosted);
+	createParam(P_PollSuppressedString, asynParamFloat64, &P_PollSuppressed);
+	for(int i=0; i<numBoards(); ++i)
+	{
+		setIntegerParam(i, P_CacheHits, 0);
+		setIntegerParam(i, P_CacheMisses, 0);
+		setIntegerParam(i, P_CacheAge, 0);
+		setIntegerParam(i, P_CacheWords, 0);
+		setIntegerParam(i, P_ConfigStatus, ConfigOK);
+		setIntegerParam(i, P_ConfigMismatches, 0);
+		setIntegerParam(i, P_ConfigDatagrams, 0);
+		setStringParam(i, P_DumpFile, "");
+		setIntegerParam(i, P_DumpStart, 0);
+		setIntegerParam(i, P_DumpWords, 0);
+		setIntegerParam(i, P_DumpStatus, DumpIdle);
+		setIntegerParam(i, P_DumpDone, 0);
+		setDoubleParam(i, P_DumpRate, 0.0);
+	}
+
+    // Create a thread per board for background tasks, used for polling memory for I/O intr records
+	for(int i=0; i<numBoards(); ++i)
+	{
+		char name[32];
+		PollerArg* arg = new PollerArg;
+		arg->driver = this;
+		arg->board = i;
+		if (i == 0)
+		{
+			strcpy(name, "isisdaePoller");
+		}
+		else
+		{
+			epicsSnprintf(name, sizeof(name), "isisdaePoller%d", i);
+		}
+		if (epicsThreadCreate(name,
+							  epicsThreadPriorityMedium,
+							  epicsThreadGetStackSize(epicsThreadStackMedium),
+							  (EPICSTHREADFUNC)pollerThreadC, arg) == 0)
+		{
+			printf("%s:%s: epicsThreadCreate failure\n", driverName, functionName);
+			delete arg;
+			return;
+		}
+	}
+}
+
+void daedataDriver::pollerThreadC(void* arg)
+{ 
+    PollerArg* parg = (PollerArg*)arg; 
+	parg->driver->pollerThread(parg->board);
+	delete parg;
+}
+
+/// scheduler for a board's poll range table, reads everything that is due as one batch of block reads
+void daedataDriver::pollerThread(int board)
+{
+    static const char* functionName = "isisdaePoller";
+	Board& b = *m_boards[board];
+	std::vector<PollRange> due;
+	while(true)
+	{
+		double wait = 1.0;
+		due.clear();
+		lock();
+		if (b.poll_ranges_dirty)
+		{
+			buildPollRanges(b);
+		}
+		epicsTime now = epicsTime::getCurrent();
+		if (!(now < b.next_link_update))
+		{
+			publishLink(board);
+			b.next_link_update = now + LINK_UPDATE_PERIOD;
+		}
+		wait = std::min(wait, b.next_link_update - now);
+		for(size_t i=0; i<b.poll_ranges.size(); ++i)
+		{
+			PollRange& range = b.poll_ranges[i];
+			if (!(now < range.next_poll))
+			{
+				due.push_back(range);
+				// keep to the schedule, unless we have fallen a whole period behind
+				range.next_poll += range.period;
+				if (range.next_poll < now)
+				{
+					range.next_poll = now + range.period;
+				}
+			}
+			wait = std::min(wait, range.next_poll - now);
+		}
+		unlock();
+		if (!due.empty())
+		{
+			pollRanges(board, due);
+		}
+		else if (wait > 0.0)
+		{
+			epicsThreadSleep(wait);
+		}
+	}
+}	
+
+/// read a batch of poll ranges from a board, update its shadow memory and post values to I/O Intr records.
+/// called without the driver lock so the asyn port and the other boards' pollers are not held up while we talk to the DAE
+void daedataDriver::pollRanges(int board, const std::vector<PollRange>& ranges)
+{
+	Board& b = *m_boards[board];
+	std::vector<DAEDataUDP::Block> blocks(ranges.size());
+	size_t nwords = 0;
+	for(size_t i=0; i<ranges.size(); ++i)
+	{
+		nwords += ranges[i].nwords;
+	}
+	b.poll_buffer.resize(nwords);
+	for(size_t i=0, offset=0; i<ranges.size(); offset += ranges[i].nwords, ++i)
+	{
+		blocks[i].start_address = ranges[i].start;
+		blocks[i].data = &(b.poll_buffer[offset]);
+		blocks[i].block_size = ranges[i].nwords;
+		blocks[i].format = DAEDataUDP::Words32;
+		blocks[i].offset = 0;
+	}
+	std::vector<asynStatus> status(ranges.size(), asynSuccess);
+	try
+	{
+		b.udp->readBlocks(&(blocks[0]), blocks.size(), pasynUserSelf);
+	}
+	catch(const std::exception& ex)
+	{
+		// find out which ranges are failing, unless the board is not answering at all
+		const DAEDataError* error = dynamic_cast<const DAEDataError*>(&ex);
+		bool link_down = (error != NULL && error->code == DAEDataError::LinkDown);
+		for(size_t i=0; i<blocks.size(); ++i)
+		{
+			if (link_down)
+			{
+				status[i] = asynError;
+				continue;
+			}
+			try
+			{
+				b.udp->readBlocks(&(blocks[i]), 1, pasynUserSelf);
+			}
+			catch(const std::exception& ex)
+			{
+				asynPrint(pasynUserSelf, ASYN_TRACE_ERROR, "%s:pollRanges: reading 0x%x from %s: %s\n", driverName, blocks[i].start_address, b.host.c_str(), ex.what());
+				status[i] = asynError;
+			}
+		}
+	}
+	epicsTime now = epicsTime::getCurrent();
+	lock();
+	for(size_t i=0; i<blocks.size(); ++i)
+	{
+		if (status[i] == asynSuccess)
+		{
+			b.shadow.update(blocks[i].start_address, (const epicsUInt32*)blocks[i].data, blocks[i].block_size, now);
+		}
+		setIntegerParam(board, P_CacheWords, (int)b.shadow.size());
+		publishRange(board, blocks[i].start_address, (epicsUInt32*)blocks[i].data, blocks[i].block_size, status[i]);
+		decodeRegisters(board, blocks[i].start_address, (const epicsUInt32*)blocks[i].data, blocks[i].block_size, status[i]);
+	}
+	setDoubleParam(board, P_PollPosted, b.posted);
+	setDoubleParam(board, P_PollSuppressed, b.suppressed);
+	callParamCallbacks(board);
+	unlock();
+}
+
+/// \return whether any of n words differ from those last posted by more than deadband
+static bool pollChanged(const epicsUInt32* data, const epicsUInt32* last, size_t n, unsigned deadband)
+{
+	if (deadband == 0)
+	{
+		return !std::equal(data, data + n, last);
+	}
+	for(size_t i=0; i<n; ++i)
+	{
+		epicsUInt32 diff = data[i] - last[i];
+		if (std::min(diff, 0u - diff) > deadband)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/// post the values of any of a board's I/O Intr record addresses that lie entirely within a block just read,
+/// if they or the status of the read have changed since last posted. Until iocInit has finished, and so 
+/// records may not yet be listening, everything is posted
+void daedataDriver::publishRange(int board, unsigned start, epicsUInt32* data, size_t nwords, asynStatus status)
+{
+	Board& b = *m_boards[board];
+	unsigned end = start + 4 * (unsigned)nwords;
+	for(std::multimap<unsigned, PollParam>::iterator it = b.poll_params.lower_bound(start); 
+		it != b.poll_params.end() && it->first < end; ++it)
+	{
+		PollParam& pp = it->second;
+		size_t offset = (it->first - start) / 4;
+		if ( (it->first - start) % 4 != 0 || it->first + 4 * pp.nwords > end )
+		{
+			continue;
+		}
+		if (pp.posted && status == pp.status && (status != asynSuccess || !pollChanged(data + offset, &(pp.last[0]), pp.nwords, pp.deadband)))
+		{
+			b.suppressed += 1.0;
+			continue;
+		}
+		b.posted += 1.0;
+		if (status == asynSuccess)
+		{
+			std::copy(data + offset, data + offset + pp.nwords, pp.last.begin());
+		}
+		pp.status = status;
+		pp.posted = (interruptAccept != 0);
+		if (pp.array)
+		{
+			if (status == asynSuccess)
+			{
+				doCallbacksInt32Array((epicsInt32*)data + offset, pp.nwords, pp.param, board);
+			}
+		}
+		else
+		{
+			if (status == asynSuccess)
+			{
+				setIntegerParam(board, pp.param, data[offset]);
+			}
+			setParamStatus(board, pp.param, status);
+		}
+	}
+}
+
+/// decode the fields of any of a board's register maps lying entirely within a block just read, in one pass
+/// over the map's table and only if the block has changed, posting just the fields whose values have changed
+void daedataDriver::decodeRegisters(int board, unsigned start, const epicsUInt32* data, size_t nwords, asynStatus status)
+{
+	std::vector<RegisterBlock>& register_blocks = m_boards[board]->register_blocks;
+	unsigned end = start + 4 * (unsigned)nwords;
+	for(size_t i=0; i<register_blocks.size(); ++i)
+	{
+		RegisterBlock& rb = register_blocks[i];
+		size_t n = rb.map.nwords();
+		if (rb.base < start || rb.base + 4 * (unsigned)n > end || (rb.base - start) % 4 != 0)
+		{
+			continue;
+		}
+		if (status != rb.status)
+		{
+			for(size_t j=0; j<rb.params.size(); ++j)
+			{
+				setParamStatus(board, rb.params[j], status);
+			}
+			rb.status = status;
+		}
+		if (status == asynSuccess)
+		{
+			decodeBlock(board, rb, data + (rb.base - start) / 4);
+		}
+	}
+}
+
+/// decode a register block's fields from its words, if they have changed, setting the parameters of those fields whose values have changed
+void daedataDriver::decodeBlock(int board, RegisterBlock& rb, const epicsUInt32* words)
+{
+	Board& b = *m_boards[board];
+	size_t n = rb.map.nwords();
+	const std::vector<DAEDataRegisterMap::Field>& fields = rb.map.fields();
+	if (rb.decoded && interruptAccept && std::equal(words, words + n, rb.words.begin()))
+	{
+		b.suppressed += (double)fields.size();
+		return;
+	}
+	for(size_t j=0; j<fields.size(); ++j)
+	{
+		epicsUInt32 value = DAEDataRegisterMap::extract(fields[j], words);
+		if (!rb.decoded || !interruptAccept || value != rb.values[j])
+		{
+			setIntegerParam(board, rb.params[j], (epicsInt32)value);
+			rb.values[j] = value;
+			b.posted += 1.0;
+		}
+		else
+		{
+			b.suppressed += 1.0;
+		}
+	}
+	std::copy(words, words + n, rb.words.begin());
+	rb.decoded = true;
+}
+
+/// \return the register block of a board that a register map field parameter belongs to, and the field's index in it, or NULL
+daedataDriver::RegisterBlock* daedataDriver::findRegisterField(int board, int param, size_t& field)
+{
+	std::vector<RegisterBlock>& register_blocks = m_boards[board]->register_blocks;
+	for(size_t i=0; i<register_blocks.size(); ++i)
+	{
+		std::vector<int>::const_iterator it = std::find(register_blocks[i].params.begin(), register_blocks[i].params.end(), param);
+		if (it != register_blocks[i].params.end())
+		{
+			field = it - register_blocks[i].params.begin();
+			return &(register_blocks[i]);
+		}
+	}
+	return NULL;
+}
+
+/// \return why an asyn parameter for a polled address or register map field could not be created, which is
+/// that the MAX_ADDRESS_PARAMS parameters set aside for them when the port was created are all in use
+std::string daedataDriver::paramPoolError(const std::string& name) const
+{
+	std::ostringstream oss;
+	oss << "cannot create parameter \"" << name << "\", all " << MAX_ADDRESS_PARAMS << " parameters for polled addresses and register map fields are in use (" 
+	    << m_poll_param_address.size() << " polled addresses, " << m_register_params.size() << " register map fields), increase MAX_ADDRESS_PARAMS in daedataDriver.h";
+	return oss.str();
+}
+
+/// load a register map for the block of a board's memory at base, with an asyn parameter prefix + name for
+/// each field. Boards given the same prefix share parameters, posted on each board's address list as with
+/// poll records. The block is polled every period seconds, merged with the poll records' ranges
+void daedataDriver::addRegisterMap(int board, const std::string& filename, unsigned base, const std::string& prefix, double period)
+{
+	RegisterBlock rb;
+	rb.map.load(filename);
+	if (rb.map.fields().empty())
+	{
+		throw std::runtime_error("no fields in register map " + filename);
+	}
+	rb.base = base;
+	rb.period = period;
+	rb.words.resize(rb.map.nwords());
+	rb.values.resize(rb.map.fields().size());
+	rb.status = asynSuccess;
+	rb.decoded = false;
+	lock();
+	for(size_t i=0; i<rb.map.fields().size(); ++i)
+	{
+		std::string name = prefix + rb.map.fields()[i].name;
+		int param;
+		if (findParam(name.c_str(), &param) != asynSuccess && createParam(name.c_str(), asynParamInt32, &param) != asynSuccess)
+		{
+			std::string error = paramPoolError(name);
+			unlock();
+			throw std::runtime_error(error);
+		}
+		rb.params.push_back(param);
+		m_register_params.insert(param);
+	}
+	m_boards[board]->register_blocks.push_back(rb);
+	m_boards[board]->poll_ranges_dirty = true;
+	unlock();
+}
+
+/// post a board's link counters and round trip time to the LINK_* parameters. The counters are read without
+/// locking, the round trip time and link state under the board's DAEDataUDP locks that are only held briefly 
+/// (m_request_lock and m_link_lock), never the channel or write locks held for a whole read or write, so this does 
+/// not hold up behind a transfer in progress. They are posted as doubles so they count past 2^31 without going 
+/// negative, though see DAEDataUDP::Counters for their wrap on 32 bit targets. Called with the driver locked
+void daedataDriver::publishLink(int board)
+{
+	DAEDataUDP::Counters counters;
+	DAEDataUDP::Stats stats;
+	DAEDataUDP::LinkState link;
+	m_boards[board]->udp->getCounters(counters);
+	m_boards[board]->udp->getStats(stats);
+	m_boards[board]->udp->getLinkState(link);
+	setIntegerParam(board, P_LinkUp, (link.up ? 1 : 0));
+	setDoubleParam(board, P_LinkRejected, (double)counters.rejected);
+	setDoubleParam(board, P_LinkReads, (double)counters.read_requests);
+	setDoubleParam(board, P_LinkReadBytes, (double)counters.read_bytes);
+	setDoubleParam(board, P_LinkRetransmits, (double)counters.retransmits);
+	setDoubleParam(board, P_LinkTimeouts, (double)counters.timeouts);
+	setDoubleParam(board, P_LinkStale, (double)counters.stale);
+	setDoubleParam(board, P_LinkSizeErrors, (double)counters.size_errors);
+	setDoubleParam(board, P_LinkWrites, (double)counters.write_requests);
+	setDoubleParam(board, P_LinkWriteBytes, (double)counters.write_bytes);
+	setDoubleParam(board, P_LinkSendErrors, (double)counters.send_errors);
+	setDoubleParam(board, P_LinkVerifyRereads, (double)counters.verify_rereads);
+	setDoubleParam(board, P_LinkVerifyFailures, (double)counters.verify_failures);
+	setDoubleParam(board, P_LinkRTT, 1000.0 * stats.srtt);
+	setDoubleParam(board, P_LinkRTO, 1000.0 * stats.rto);
+	callParamCallbacks(board);
+	epicsFloat64 hist[DAEDataUDP::RTT_BUCKETS], limits[DAEDataUDP::RTT_BUCKETS - 1];
+	for(int i=0; i<DAEDataUDP::RTT_BUCKETS; ++i)
+	{
+		hist[i] = (epicsFloat64)counters.rtt[i];
+	}
+	for(int i=0; i<DAEDataUDP::RTT_BUCKETS - 1; ++i)
+	{
+		limits[i] = 1000.0 * DAEDataUDP::rttBucketLimit(i);
+	}
+	doCallbacksFloat64Array(hist, DAEDataUDP::RTT_BUCKETS, P_LinkRTTHist, board);
+	doCallbacksFloat64Array(limits, DAEDataUDP::RTT_BUCKETS - 1, P_LinkRTTLimits, board);
+}
+
+/// rebuild a board's automatic poll ranges by merging, for each scan period, the sorted record addresses 
+/// into block reads, joining neighbours separated by at most m_scan_gap unused words
+void daedataDriver::buildPollRanges(Board& b)
+{
+	std::vector<PollRange> ranges;
+	for(size_t i=0; i<b.poll_ranges.size(); ++i)
+	{
+		if (!b.poll_ranges[i].automatic)
+		{
+			ranges.push_back(b.poll_ranges[i]);
+		}
+	}
+	// register map blocks are read along with the poll records
+	std::multimap<unsigned, PollParam> poll_params(b.poll_params);
+	for(size_t i=0; i<b.register_blocks.size(); ++i)
+	{
+		PollParam pp;
+		pp.param = -1;
+		pp.nwords = b.register_blocks[i].map.nwords();
+		pp.array = true;
+		pp.period = b.register_blocks[i].period;
+		pp.deadband = 0;
+		pp.status = asynSuccess;
+		pp.posted = false;
+		poll_params.insert(std::pair<unsigned, PollParam>(b.register_blocks[i].base, pp));
+	}
+	std::map<double, std::vector<PollRange> > by_period;
+	for(std::multimap<unsigned, PollParam>::const_iterator it = poll_params.begin(); it != poll_params.end(); ++it)
+	{
+		unsigned address = it->first;
+		unsigned end = address + 4 * (unsigned)it->second.nwords;
+		std::vector<PollRange>& pr = by_period[it->second.period];
+		if (!pr.empty())
+		{
+			PollRange& last = pr.back();
+			unsigned last_end = last.start + 4 * (unsigned)last.nwords; // first address after range
+			if (address <= last_end + 4 * (unsigned)m_scan_gap && (address - last.start) % 4 == 0)
+			{
+				last.nwords = std::max(last.nwords, (size_t)((end - last.start) / 4));
+				continue;
+			}
+		}
+		pr.push_back(PollRange(address, it->second.nwords, it->second.period, true));
+	}
+	for(std::map<double, std::vector<PollRange> >::const_iterator it = by_period.begin(); it != by_period.end(); ++it)
+	{
+		ranges.insert(ranges.end(), it->second.begin(), it->second.end());
+	}
+	b.poll_ranges.swap(ranges);
+	b.poll_ranges_dirty = false;
+}
+
+/// add an I/O Intr record address on a board to that board's poller. Records with the same address and
+/// polling options, on the same or different boards, share an asyn parameter named by DAEDataAddress::pollKey(), 
+/// with their values posted on the board's address list
+/// \return asyn parameter index the record's callbacks will be made on
+int daedataDriver::addPollParam(const std::string& key, int board, unsigned address, size_t nwords, double period, unsigned deadband)
+{
+	int param;
+	if (findParam(key.c_str(), &param) != asynSuccess)
+	{
+		if (createParam(key.c_str(), (nwords > 1 ? asynParamInt32Array : asynParamInt32), &param) != asynSuccess)
+		{
+			return -1;
+		}
+		m_poll_param_address[param] = address;
+	}
+	Board& b = *m_boards[board];
+	for(std::multimap<unsigned, PollParam>::const_iterator it = b.poll_params.lower_bound(address); 
+		it != b.poll_params.end() && it->first == address; ++it)
+	{
+		if (it->second.param == param)
+		{
+			return param;
+		}
+	}
+	PollParam pp;
+	pp.param = param;
+	pp.nwords = nwords;
+	pp.array = (nwords > 1);
+	pp.period = period;
+	pp.deadband = deadband;
+	pp.last.resize(nwords);
+	pp.status = asynSuccess;
+	pp.posted = false;
+	b.poll_params.insert(std::pair<unsigned, PollParam>(address, pp));
+	b.poll_ranges_dirty = true;
+	return param;
+}
+
+/// set the read retransmit timeout (the starting point if adaptive) and retry count of every board
+void daedataDriver::setReadTimeout(double timeout, int retries)
+{
+	for(size_t i=0; i<m_boards.size(); ++i)
+	{
+		m_boards[i]->udp->setTimeout(timeout, retries);
+	}
+}
+
+/// asyn report (dbior), adds the read retransmission statistics of each board
+void daedataDriver::report(FILE* fp, int details)
+{
+	for(size_t i=0; i<m_boards.size(); ++i)
+	{
+		DAEDataUDP::Stats stats;
+		DAEDataUDP::Counters counters;
+		m_boards[i]->udp->getStats(stats);
+		m_boards[i]->udp->getCounters(counters);
+		fprintf(fp, "  board %u (%s)\n", (unsigned)i, m_boards[i]->host.c_str());
+		fprintf(fp, "    reads: %llu sent, %llu retransmitted, %llu failed, %llu stale replies, %llu wrong size\n", (unsigned long long)counters.read_requests, 
+		        (unsigned long long)counters.retransmits, (unsigned long long)counters.timeouts, (unsigned long long)counters.stale, (unsigned long long)counters.size_errors);
+		DAEDataUDP::LinkState link;
+		m_boards[i]->udp->getLinkState(link);
+		char changed[40];
+		link.changed.strftime(changed, sizeof(changed), "%Y-%m-%d %H:%M:%S");
+		fprintf(fp, "    link: %s since %s, %d reads timed out in a row, %llu requests rejected, last error %d (errno %d)\n", (link.up ? "up" : "DOWN"), 
+		        changed, link.timeouts, (unsigned long long)counters.rejected, link.last_error, link.last_errno);
+		fprintf(fp, "    writes: %llu sent, %llu send errors, %llu verify rereads, %llu verify failures\n", (unsigned long long)counters.write_requests, 
+		        (unsigned long long)counters.send_errors, (unsigned long long)counters.verify_rereads, (unsigned long long)counters.verify_failures);
+		fprintf(fp, "    round trip: %.3f ms smoothed, %.3f ms variation from %lu samples, %s timeout %.3f ms\n", 
+		        1000.0 * stats.srtt, 1000.0 * stats.rttvar, stats.rtt_samples, (stats.adaptive ? "adaptive" : "fixed"), 1000.0 * stats.rto);
+		lock();
+		double posted = m_boards[i]->posted, suppressed = m_boards[i]->suppressed;
+		unlock();
+		fprintf(fp, "    polled values: %.0f posted, %.0f unchanged and not posted\n", posted, suppressed);
+		if (details > 0)
+		{
+			fprintf(fp, "    round trip histogram:");
+			for(int j=0; j<DAEDataUDP::RTT_BUCKETS - 1; ++j)
+			{
+				fprintf(fp, " <%gms %llu", 1000.0 * DAEDataUDP::rttBucketLimit(j), (unsigned long long)counters.rtt[j]);
+			}
+			fprintf(fp, " slower %llu\n", (unsigned long long)counters.rtt[DAEDataUDP::RTT_BUCKETS - 1]);
+		}
+	}
+	asynPortDriver::report(fp, details);
+}
+
+void daedataDriver::setScanGap(int gap)
+{
+	lock();
+	m_scan_gap = (gap > 0 ? gap : 0);
+	for(size_t i=0; i<m_boards.size(); ++i)
+	{
+		m_boards[i]->poll_ranges_dirty = true;
+	}
+	unlock();
+}
+
+/// add a block of a board's memory for its poller to read every period seconds, in addition to those
+/// it reads for I/O Intr records
+void daedataDriver::addPollRange(int board, unsigned start, size_t nwords, double period)
+{
+	lock();
+	m_boards[board]->poll_ranges.push_back(PollRange(start, nwords, period, false));
+	unlock();
+}
+
+asynStatus daedataDriver::drvUserCreate(asynUser *pasynUser, const char* drvInfo, const char** pptypeName, size_t* psize)
+{
+   const char *functionName = "drvUserCreate";
+   if (strncmp(drvInfo, "0x", 2) == 0)
+   {
+       // "0x1000 scan=1" has the poller read the address every second, for use with SCAN="I/O Intr"
+       // "0x10004 scan=1 n=8" does the same for an 8 element waveform
+       // "0x1000 age=0.5" lets reads be satisfied from shadow memory if it is at most 0.5 seconds old
+       // see DAEDataAddress for the full list of modifiers
+       DAEDataAddress* addr = new DAEDataAddress;
+       std::string error;
+       if (!addr->parse(drvInfo, error))
+       {
+           epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize, 
+              "%s:%s: \"%s\": %s", driverName, functionName, drvInfo, error.c_str());
+           delete addr;
+           return asynError;
+       }
+       if (addr->scan > 0.0)
+       {
+           int board = 0;
+           if (getAddress(pasynUser, &board) != asynSuccess)
+           {
+               delete addr;
+               return asynError;
+           }
+           if ( (pasynUser->reason = addPollParam(addr->pollKey(), board, addr->address, std::max(addr->nwords, (size_t)1), addr->scan, addr->deadband)) < 0 )
+           {
+               epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize, 
+                  "%s:%s: \"%s\": %s", driverName, functionName, drvInfo, paramPoolError(addr->pollKey()).c_str());
+               delete addr;
+               return asynError;
+           }
+       }
+       else
+       {
+           pasynUser->reason = P_Address;
+       }
+       pasynUser->userData = addr;
+       asynPrint(pasynUser, ASYN_TRACE_FLOW,
+          "%s:%s: index=%d address=0x%x\n", 
+          driverName, functionName, pasynUser->reason, addr->address);
+       return asynSuccess;
+   }
+   else
+   {
+       return asynPortDriver::drvUserCreate(pasynUser, drvInfo, pptypeName, psize);
+   }
+}
+
+asynStatus daedataDriver::drvUserDestroy(asynUser *pasynUser)
+{
+   const char *functionName = "drvUserDestroy";
+   if ( isAddressParam(pasynUser->reason) )
+   {
+      DAEDataAddress* addr = (DAEDataAddress*)pasynUser->userData;
+      asynPrint(pasynUser, ASYN_TRACE_FLOW,
+          "%s:%s: index=%d address=0x%x\n", 
+          driverName, functionName, pasynUser->reason, addr->address);
+      delete addr;
+      pasynUser->userData = NULL;
+      return asynSuccess;
+  }
+  else
+  {
+      return asynPortDriver::drvUserDestroy(pasynUser);
+  }
+}
+
+extern "C" {
+
+/// EPICS iocsh callable function to call constructor of lvDCOMInterface().
+/// \param[in] portName @copydoc initArg0
+/// \param[in] host @copydoc initArg1
+/// \param[in] simulate @copydoc initArg2
+/// \param[in] options @copydoc initArg3
+/// \param[in] window @copydoc initArg4
+/// \param[in] timeout @copydoc initArg5
+/// \param[in] retries @copydoc initArg6
+int daedataConfigure(const char *portName, const char *host, int simulate, int options, int window, double timeout, int retries)
+{
+	try
+	{
+			new daedataDriver(portName, host, (simulate != 0), options, window, timeout, retries);
+			return(asynSuccess);
+	}
+	catch(const std::exception& ex)
+	{
+		std::cerr << "daedataConfigure failed: " << ex.what() << std::endl;
+		return(asynError);
+	}
+}
+
+// EPICS iocsh shell commands 
+
+static const iocshArg initArg0 = { "portName", iocshArgString};			///< The name of the asyn driver port we will create
+static const iocshArg initArg1 = { "host", iocshArgString};				///< host name or IP address of the DAE, or a comma separated list of them for a multi-device port with one board per asyn address
+static const iocshArg initArg2 = { "simulate", iocshArgInt};				///< host name where LabVIEW is running ("" for localhost) 
+static const iocshArg initArg3 = { "options", iocshArgInt};				///< bitmask of #DAEDataUDPOptions e.g. 1 = read one word per datagram, 2 = fixed rather than adaptive read timeout
+static const iocshArg initArg4 = { "window", iocshArgInt};				///< maximum number of read requests in flight, separately for polling and record I/O (0 for default, 1 for one at a time)
+static const iocshArg initArg5 = { "timeout", iocshArgDouble};			///< seconds before a read is retransmitted, the starting point for adaptive timeouts (0 for default)
+static const iocshArg initArg6 = { "retries", iocshArgInt};				///< retransmissions before a read fails (0 for default)
+
+static const iocshArg * const initArgs[] = { &initArg0,
+											 &initArg1,
+                                             &initArg2,
+                                             &initArg3,
+                                             &initArg4,
+                                             &initArg5,
+                                             &initArg6 };
 
 static const iocshFuncDef initFuncDef = {"daedataConfigure", sizeof(initArgs) / sizeof(iocshArg*), initArgs};
 
 static void initCallFunc(const iocshArgBuf *args)
 {
-    daedataConfigure(args[0].sval, args[1].sval, args[2].ival);
+    daedataConfigure(args[0].sval, args[1].sval, args[2].ival, args[3].ival, args[4].ival, args[5].dval, args[6].ival);
+}
+
+/// EPICS iocsh callable function to set the poll address gap tolerance of a daedataDriver port
+/// \param[in] portName @copydoc scanGapArg0
+/// \param[in] gap @copydoc scanGapArg1
+int daedataSetScanGap(const char *portName, int gap)
+{
+	daedataDriver* driver = dynamic_cast<daedataDriver*>((asynPortDriver*)findAsynPortDriver(portName));
+	if (driver == NULL)
+	{
+		std::cerr << "daedataSetScanGap: no daedata port " << (portName != NULL ? portName : "") << std::endl;
+		return(asynError);
+	}
+	driver->setScanGap(gap);
+	return(asynSuccess);
+}
+
+static const iocshArg scanGapArg0 = { "portName", iocshArgString};			///< The name of the daedataDriver asyn port
+static const iocshArg scanGapArg1 = { "gap", iocshArgInt};				///< number of unused words that may be read to join two polled addresses into one block
+
+static const iocshArg * const scanGapArgs[] = { &scanGapArg0, &scanGapArg1 };
+
+static const iocshFuncDef scanGapFuncDef = {"daedataSetScanGap", sizeof(scanGapArgs) / sizeof(iocshArg*), scanGapArgs};
+
+static void scanGapCallFunc(const iocshArgBuf *args)
+{
+    daedataSetScanGap(args[0].sval, args[1].ival);
+}
+
+/// EPICS iocsh callable function to have a daedataDriver port poll a block of DAE memory
+/// \param[in] portName @copydoc pollRangeArg0
+/// \param[in] start @copydoc pollRangeArg1
+/// \param[in] nwords @copydoc pollRangeArg2
+/// \param[in] period @copydoc pollRangeArg3
+/// \param[in] board @copydoc pollRangeArg4
+int daedataPollRange(const char *portName, int start, int nwords, double period, int board)
+{
+	daedataDriver* driver = dynamic_cast<daedataDriver*>((asynPortDriver*)findAsynPortDriver(portName));
+	if (driver == NULL)
+	{
+		std::cerr << "daedataPollRange: no daedata port " << (portName != NULL ? portName : "") << std::endl;
+		return(asynError);
+	}
+	if (nwords <= 0 || period <= 0.0 || board < 0 || board >= driver->numBoards())
+	{
+		std::cerr << "daedataPollRange: invalid nwords, period or board" << std::endl;
+		return(asynError);
+	}
+	driver->addPollRange(board, start, nwords, period);
+	return(asynSuccess);
+}
+
+static const iocshArg pollRangeArg0 = { "portName", iocshArgString};			///< The name of the daedataDriver asyn port
+static const iocshArg pollRangeArg1 = { "start", iocshArgInt};				///< start address of memory block
+static const iocshArg pollRangeArg2 = { "nwords", iocshArgInt};				///< number of 32 bit words in block
+static const iocshArg pollRangeArg3 = { "period", iocshArgDouble};			///< seconds between reads
+static const iocshArg pollRangeArg4 = { "board", iocshArgInt};				///< asyn address of the board to read on a multi-device port (default 0)
+
+static const iocshArg * const pollRangeArgs[] = { &pollRangeArg0, &pollRangeArg1, &pollRangeArg2, &pollRangeArg3, &pollRangeArg4 };
+
+static const iocshFuncDef pollRangeFuncDef = {"daedataPollRange", sizeof(pollRangeArgs) / sizeof(iocshArg*), pollRangeArgs};
+
+static void pollRangeCallFunc(const iocshArgBuf *args)
+{
+    daedataPollRange(args[0].sval, args[1].ival, args[2].ival, args[3].dval, args[4].ival);
+}
+
+static daedataDriver* findDriver(const char* func, const char *portName)
+{
+	daedataDriver* driver = dynamic_cast<daedataDriver*>((asynPortDriver*)findAsynPortDriver(portName));
+	if (driver == NULL)
+	{
+		std::cerr << func << ": no daedata port " << (portName != NULL ? portName : "") << std::endl;
+	}
+	return driver;
+}
+
+/// EPICS iocsh callable function to start a configuration transaction on a daedataDriver port.
+/// A port has one transaction at a time whichever board it is for, beginning one discards any other being staged
+/// \param[in] portName @copydoc configArg0
+/// \param[in] board @copydoc configArg3
+int daedataConfigBegin(const char *portName, int board)
+{
+	daedataDriver* driver = findDriver("daedataConfigBegin", portName);
+	if (driver == NULL)
+	{
+		return(asynError);
+	}
+	if (board < 0 || board >= driver->numBoards())
+	{
+		std::cerr << "daedataConfigBegin: no board " << board << std::endl;
+		return(asynError);
+	}
+	driver->configBegin(board);
+	return(asynSuccess);
+}
+
+/// EPICS iocsh callable function to stage words for writing in the current configuration transaction
+/// \param[in] portName @copydoc configArg0
+/// \param[in] address @copydoc configArg1
+/// \param[in] words @copydoc configArg2
+int daedataConfigStage(const char *portName, int address, const char* words)
+{
+	daedataDriver* driver = findDriver("daedataConfigStage", portName);
+	if (driver == NULL)
+	{
+		return(asynError);
+	}
+	std::vector<epicsUInt32> data;
+	const char* p = (words != NULL ? words : "");
+	char* endp = NULL;
+	while(*p != '\0')
+	{
+		epicsUInt32 w = strtoul(p, &endp, 0);
+		if (endp == p)
+		{
+			if (isspace(*p) || *p == ',')
+			{
+				++p;
+				continue;
+			}
+			std::cerr << "daedataConfigStage: invalid word \"" << p << "\"" << std::endl;
+			return(asynError);
+		}
+		data.push_back(w);
+		p = endp;
+	}
+	if (data.empty() || address % 4 != 0)
+	{
+		std::cerr << "daedataConfigStage: need a word aligned address and at least one word" << std::endl;
+		return(asynError);
+	}
+	driver->configStage(address, &(data[0]), data.size());
+	return(asynSuccess);
+}
+
+/// EPICS iocsh callable function to write and verify the current configuration transaction
+/// \param[in] portName @copydoc configArg0
+int daedataConfigCommit(const char *portName)
+{
+	daedataDriver* driver = findDriver("daedataConfigCommit", portName);
+	if (driver == NULL)
+	{
+		return(asynError);
+	}
+	return driver->configCommit();
+}
+
+static const iocshArg configArg0 = { "portName", iocshArgString};			///< The name of the daedataDriver asyn port
+static const iocshArg configArg1 = { "address", iocshArgInt};				///< address of first word
+static const iocshArg configArg2 = { "words", iocshArgString};			///< space or comma separated words to write from address onwards
+static const iocshArg configArg3 = { "board", iocshArgInt};				///< asyn address of the board to configure on a multi-device port (default 0)
+
+static const iocshArg * const configBeginArgs[] = { &configArg0, &configArg3 };
+static const iocshArg * const configStageArgs[] = { &configArg0, &configArg1, &configArg2 };
+static const iocshArg * const configCommitArgs[] = { &configArg0 };
+
+static const iocshFuncDef configBeginFuncDef = {"daedataConfigBegin", sizeof(configBeginArgs) / sizeof(iocshArg*), configBeginArgs};
+static const iocshFuncDef configStageFuncDef = {"daedataConfigStage", sizeof(configStageArgs) / sizeof(iocshArg*), configStageArgs};
+static const iocshFuncDef configCommitFuncDef = {"daedataConfigCommit", sizeof(configCommitArgs) / sizeof(iocshArg*), configCommitArgs};
+
+static void configBeginCallFunc(const iocshArgBuf *args)
+{
+    daedataConfigBegin(args[0].sval, args[1].ival);
+}
+
+static void configStageCallFunc(const iocshArgBuf *args)
+{
+    daedataConfigStage(args[0].sval, args[1].ival, args[2].sval);
+}
+
+static void configCommitCallFunc(const iocshArgBuf *args)
+{
+    daedataConfigCommit(args[0].sval);
+}
+
+/// EPICS iocsh callable function to tune read retransmission on a daedataDriver port
+/// \param[in] portName @copydoc timeoutArg0
+/// \param[in] timeout @copydoc timeoutArg1
+/// \param[in] retries @copydoc timeoutArg2
+int daedataSetTimeout(const char *portName, double timeout, int retries)
+{
+	daedataDriver* driver = findDriver("daedataSetTimeout", portName);
+	if (driver == NULL)
+	{
+		return(asynError);
+	}
+	driver->setReadTimeout(timeout, retries);
+	return(asynSuccess);
+}
+
+static const iocshArg timeoutArg0 = { "portName", iocshArgString};			///< The name of the daedataDriver asyn port
+static const iocshArg timeoutArg1 = { "timeout", iocshArgDouble};			///< seconds to wait for a read reply before retransmitting, the starting point if adaptive and its ceiling if over 1 second (0 to leave unchanged)
+static const iocshArg timeoutArg2 = { "retries", iocshArgInt};				///< retransmissions before a read fails (-1 to leave unchanged)
+
+static const iocshArg * const timeoutArgs[] = { &timeoutArg0, &timeoutArg1, &timeoutArg2 };
+
+static const iocshFuncDef timeoutFuncDef = {"daedataSetTimeout", sizeof(timeoutArgs) / sizeof(iocshArg*), timeoutArgs};
+
+static void timeoutCallFunc(const iocshArgBuf *args)
+{
+    daedataSetTimeout(args[0].sval, args[1].dval, args[2].ival);
+}
+
+/// EPICS iocsh callable function to stream a region of DAE memory to a file of host order 32 bit words.
+/// Running it again with the same arguments after a failure carries on from the last completed chunk.
+/// A port runs one dump at a time whichever board it reads, and only remembers where the last one got to
+/// \param[in] portName @copydoc dumpArg0
+/// \param[in] filename @copydoc dumpArg1
+/// \param[in] start @copydoc dumpArg2
+/// \param[in] nwords @copydoc dumpArg3
+/// \param[in] board @copydoc dumpArg4
+int daedataDump(const char *portName, const char* filename, int start, int nwords, int board)
+{
+	daedataDriver* driver = findDriver("daedataDump", portName);
+	if (driver == NULL)
+	{
+		return(asynError);
+	}
+	if (nwords <= 0 || board < 0 || board >= driver->numBoards())
+	{
+		std::cerr << "daedataDump: need at least one word and a valid board" << std::endl;
+		return(asynError);
+	}
+	return driver->dump(board, filename != NULL ? filename : "", start, nwords);
+}
+
+static const iocshArg dumpArg0 = { "portName", iocshArgString};			///< The name of the daedataDriver asyn port
+static const iocshArg dumpArg1 = { "filename", iocshArgString};			///< file to write, created or overwritten
+static const iocshArg dumpArg2 = { "start", iocshArgInt};				///< address of first word
+static const iocshArg dumpArg3 = { "nwords", iocshArgInt};				///< number of 32 bit words to dump
+static const iocshArg dumpArg4 = { "board", iocshArgInt};				///< asyn address of the board to read on a multi-device port (default 0)
+
+static const iocshArg * const dumpArgs[] = { &dumpArg0, &dumpArg1, &dumpArg2, &dumpArg3, &dumpArg4 };
+
+static const iocshFuncDef dumpFuncDef = {"daedataDump", sizeof(dumpArgs) / sizeof(iocshArg*), dumpArgs};
+
+static void dumpCallFunc(const iocshArgBuf *args)
+{
+    daedataDump(args[0].sval, args[1].sval, args[2].ival, args[3].ival, args[4].ival);
+}
+
+/// EPICS iocsh callable function to list the datagram conversion kernels and optionally choose which to use
+/// \param[in] name @copydoc kernelsArg0
+int daedataUseKernels(const char* name)
+{
+	if (name != NULL && *name != '\0' && !daedataSelectKernels(name))
+	{
+		std::cerr << "daedataUseKernels: \"" << name << "\" not available" << std::endl;
+		return(asynError);
+	}
+	for(size_t i=0; daedataKernelsAt(i) != NULL; ++i)
+	{
+		const DAEDataKernels* kernels = daedataKernelsAt(i);
+		std::cout << (kernels == &daedataKernels() ? "* " : "  ") << kernels->name << std::endl;
+	}
+	return(asynSuccess);
+}
+
+static const iocshArg kernelsArg0 = { "name", iocshArgString};			///< kernels to use: scalar, sse2, ssse3 or auto ("" to just list them)
+
+static const iocshArg * const kernelsArgs[] = { &kernelsArg0 };
+
+static const iocshFuncDef kernelsFuncDef = {"daedataUseKernels", sizeof(kernelsArgs) / sizeof(iocshArg*), kernelsArgs};
+
+static void kernelsCallFunc(const iocshArgBuf *args)
+{
+    daedataUseKernels(args[0].sval);
+}
+
+/// EPICS iocsh callable function to load a register map for a block of DAE memory, see DAEDataRegisterMap for the file format.
+/// Each field is decoded into the asyn parameter prefix + name whenever the block is polled, for I/O Intr records
+/// \param[in] portName @copydoc registerMapArg0
+/// \param[in] filename @copydoc registerMapArg1
+/// \param[in] base @copydoc registerMapArg2
+/// \param[in] prefix @copydoc registerMapArg3
+/// \param[in] period @copydoc registerMapArg4
+/// \param[in] board @copydoc registerMapArg5
+int daedataRegisterMap(const char *portName, const char* filename, int base, const char* prefix, double period, int board)
+{
+	daedataDriver* driver = findDriver("daedataRegisterMap", portName);
+	if (driver == NULL)
+	{
+		return(asynError);
+	}
+	if (filename == NULL || base % 4 != 0 || board < 0 || board >= driver->numBoards())
+	{
+		std::cerr << "daedataRegisterMap: need a file, a word aligned base address and a valid board" << std::endl;
+		return(asynError);
+	}
+	try
+	{
+		driver->addRegisterMap(board, filename, base, (prefix != NULL ? prefix : ""), (period > 0.0 ? period : 1.0));
+	}
+	catch(const std::exception& ex)
+	{
+		std::cerr << "daedataRegisterMap: " << ex.what() << std::endl;
+		return(asynError);
+	}
+	return(asynSuccess);
+}
+
+static const iocshArg registerMapArg0 = { "portName", iocshArgString};			///< The name of the daedataDriver asyn port
+static const iocshArg registerMapArg1 = { "filename", iocshArgString};			///< register map file
+static const iocshArg registerMapArg2 = { "base", iocshArgInt};				///< address of word 0 of the map
+static const iocshArg registerMapArg3 = { "prefix", iocshArgString};			///< put in front of the field names to make the asyn parameter names, e.g. "DSP0_"
+static const iocshArg registerMapArg4 = { "period", iocshArgDouble};			///< seconds between reads of the block (0 for 1 second)
+static const iocshArg registerMapArg5 = { "board", iocshArgInt};				///< asyn address of the board on a multi-device port (default 0)
+
+static const iocshArg * const registerMapArgs[] = { &registerMapArg0, &registerMapArg1, &registerMapArg2, &registerMapArg3, &registerMapArg4, &registerMapArg5 };
+
+static const iocshFuncDef registerMapFuncDef = {"daedataRegisterMap", sizeof(registerMapArgs) / sizeof(iocshArg*), registerMapArgs};
+
+static void registerMapCallFunc(const iocshArgBuf *args)
+{
+    daedataRegisterMap(args[0].sval, args[1].sval, args[2].ival, args[3].sval, args[4].dval, args[5].ival);
+}
+
+/// EPICS iocsh callable function to add a range of DAE memory to a board's snapshots, which also include its register map blocks
+/// \param[in] portName @copydoc snapshotRangeArg0
+/// \param[in] start @copydoc snapshotRangeArg1
+/// \param[in] nwords @copydoc snapshotRangeArg2
+/// \param[in] board @copydoc snapshotRangeArg3
+int daedataSnapshotRange(const char *portName, int start, int nwords, int board)
+{
+	daedataDriver* driver = findDriver("daedataSnapshotRange", portName);
+	if (driver == NULL)
+	{
+		return(asynError);
+	}
+	if (nwords <= 0 || start % 4 != 0 || board < 0 || board >= driver->numBoards())
+	{
+		std::cerr << "daedataSnapshotRange: need a word aligned start address, at least one word and a valid board" << std::endl;
+		return(asynError);
+	}
+	driver->addSnapshotRange(board, start, nwords);
+	return(asynSuccess);
+}
+
+/// EPICS iocsh callable function to save a snapshot of a board's memory, see DAEDataSnapshot for the file format
+/// \param[in] portName @copydoc snapshotArg0
+/// \param[in] filename @copydoc snapshotArg1
+/// \param[in] board @copydoc snapshotArg2
+int daedataSnapshot(const char *portName, const char* filename, int board)
+{
+	daedataDriver* driver = findDriver("daedataSnapshot", portName);
+	if (driver == NULL)
+	{
+		return(asynError);
+	}
+	if (filename == NULL || board < 0 || board >= driver->numBoards())
+	{
+		std::cerr << "daedataSnapshot: need a file and a valid board" << std::endl;
+		return(asynError);
+	}
+	return driver->snapshot(board, filename);
+}
+
+/// EPICS iocsh callable function to compare a snapshot with a board, listing the words that differ
+/// \param[in] portName @copydoc snapshotArg0
+/// \param[in] filename @copydoc snapshotArg1
+/// \param[in] board @copydoc snapshotArg2
+int daedataSnapshotDiff(const char *portName, const char* filename, int board)
+{
+	daedataDriver* driver = findDriver("daedataSnapshotDiff", portName);
+	if (driver == NULL)
+	{
+		return(asynError);
+	}
+	if (filename == NULL || board < 0 || board >= driver->numBoards())
+	{
+		std::cerr << "daedataSnapshotDiff: need a file and a valid board" << std::endl;
+		return(asynError);
+	}
+	return driver->snapshotDiff(board, filename);
+}
+
+/// EPICS iocsh callable function to restore a board from a snapshot, writing only the words that differ
+/// \param[in] portName @copydoc snapshotArg0
+/// \param[in] filename @copydoc snapshotArg1
+/// \param[in] board @copydoc snapshotArg2
+/// \param[in] force @copydoc snapshotArg3
+int daedataSnapshotRestore(const char *portName, const char* filename, int board, int force)
+{
+	daedataDriver* driver = findDriver("daedataSnapshotRestore", portName);
+	if (driver == NULL)
+	{
+		return(asynError);
+	}
+	if (filename == NULL || board < 0 || board >= driver->numBoards())
+	{
+		std::cerr << "daedataSnapshotRestore: need a file and a valid board" << std::endl;
+		return(asynError);
+	}
+	return driver->snapshotRestore(board, filename, (force != 0));
+}
+
+static const iocshArg snapshotRangeArg0 = { "portName", iocshArgString};			///< The name of the daedataDriver asyn port
+static const iocshArg snapshotRangeArg1 = { "start", iocshArgInt};				///< address of first word
+static const iocshArg snapshotRangeArg2 = { "nwords", iocshArgInt};				///< number of 32 bit words in the range
+static const iocshArg snapshotRangeArg3 = { "board", iocshArgInt};				///< asyn address of the board on a multi-device port (default 0)
+
+static const iocshArg * const snapshotRangeArgs[] = { &snapshotRangeArg0, &snapshotRangeArg1, &snapshotRangeArg2, &snapshotRangeArg3 };
+
+static const iocshFuncDef snapshotRangeFuncDef = {"daedataSnapshotRange", sizeof(snapshotRangeArgs) / sizeof(iocshArg*), snapshotRangeArgs};
+
+static void snapshotRangeCallFunc(const iocshArgBuf *args)
+{
+    daedataSnapshotRange(args[0].sval, args[1].ival, args[2].ival, args[3].ival);
+}
+
+static const iocshArg snapshotArg0 = { "portName", iocshArgString};			///< The name of the daedataDriver asyn port
+static const iocshArg snapshotArg1 = { "filename", iocshArgString};			///< snapshot file
+static const iocshArg snapshotArg2 = { "board", iocshArgInt};				///< asyn address of the board on a multi-device port (default 0)
+static const iocshArg snapshotArg3 = { "force", iocshArgInt};				///< 1 to restore even if the board's firmware words differ from the snapshot's
+
+static const iocshArg * const snapshotArgs[] = { &snapshotArg0, &snapshotArg1, &snapshotArg2 };
+static const iocshArg * const snapshotRestoreArgs[] = { &snapshotArg0, &snapshotArg1, &snapshotArg2, &snapshotArg3 };
+
+static const iocshFuncDef snapshotFuncDef = {"daedataSnapshot", sizeof(snapshotArgs) / sizeof(iocshArg*), snapshotArgs};
+static const iocshFuncDef snapshotDiffFuncDef = {"daedataSnapshotDiff", sizeof(snapshotArgs) / sizeof(iocshArg*), snapshotArgs};
+static const iocshFuncDef snapshotRestoreFuncDef = {"daedataSnapshotRestore", sizeof(snapshotRestoreArgs) / sizeof(iocshArg*), snapshotRestoreArgs};
+
+static void snapshotCallFunc(const iocshArgBuf *args)
+{
+    daedataSnapshot(args[0].sval, args[1].sval, args[2].ival);
+}
+
+static void snapshotDiffCallFunc(const iocshArgBuf *args)
+{
+    daedataSnapshotDiff(args[0].sval, args[1].sval, args[2].ival);
+}
+
+static void snapshotRestoreCallFunc(const iocshArgBuf *args)
+{
+    daedataSnapshotRestore(args[0].sval, args[1].sval, args[2].ival, args[3].ival);
 }
 
 static void daedataRegister(void)
 {
+    iocshRegister(&timeoutFuncDef, timeoutCallFunc);
+    iocshRegister(&dumpFuncDef, dumpCallFunc);
+    iocshRegister(&kernelsFuncDef, kernelsCallFunc);
     iocshRegister(&initFuncDef, initCallFunc);
+    iocshRegister(&scanGapFuncDef, scanGapCallFunc);
+    iocshRegister(&pollRangeFuncDef, pollRangeCallFunc);
+    iocshRegister(&configBeginFuncDef, configBeginCallFunc);
+    iocshRegister(&configStageFuncDef, configStageCallFunc);
+    iocshRegister(&configCommitFuncDef, configCommitCallFunc);
+    iocshRegister(&registerMapFuncDef, registerMapCallFunc);
+    iocshRegister(&snapshotRangeFuncDef, snapshotRangeCallFunc);
+    iocshRegister(&snapshotFuncDef, snapshotCallFunc);
+    iocshRegister(&snapshotDiffFuncDef, snapshotDiffCallFunc);
+    iocshRegister(&snapshotRestoreFuncDef, snapshotRestoreCallFunc);
 }
 
 epicsExportRegistrar(daedataRegister);
@@ -1,19 +1,34 @@
 #ifndef DAEDATADRIVER_H
 #define DAEDATADRIVER_H
  
+#include <map>
+#include <set>
+#include <vector>
+#include <string>
+
 #include "asynPortDriver.h"
+#include "epicsTime.h"
+
+#include "daedataShadow.h"
+#include "daedataConfig.h"
+#include "daedataDump.h"
+#include "daedataRegisterMap.h"
+#include "daedataSnapshot.h"
 
-class DAEDataUDP;
+struct DAEDataAddress;
 
 class daedataDriver : public asynPortDriver 
 {
 public:
-    daedataDriver(const char *portName, const char* host, bool simulate);
+    daedataDriver(const char *portName, const char* host, bool simulate, int options, int window, double timeout, int retries);
  	static void pollerThreadC(void* arg);
+ 	static void dumpThreadC(void* arg);
                 
     // These are the methods that we override from asynPortDriver
     virtual asynStatus writeInt32(asynUser *pasynUser, epicsInt32 value);
 	virtual asynStatus readInt32(asynUser *pasynUser, epicsInt32 *value);
+    virtual asynStatus writeUInt32Digital(asynUser *pasynUser, epicsUInt32 value, epicsUInt32 mask);
+    virtual asynStatus readUInt32Digital(asynUser *pasynUser, epicsUInt32 *value, epicsUInt32 mask);
     virtual asynStatus readInt32Array(asynUser *pasynUser, epicsInt32 *value, size_t nElements, size_t *nIn);
     virtual asynStatus writeInt32Array(asynUser *pasynUser, epicsInt32 *value, size_t nElements);
     virtual asynStatus readInt16Array(asynUser *pasynUser, epicsInt16 *value, size_t nElements, size_t *nIn);
@@ -21,19 +36,186 @@ public:
 
     virtual asynStatus drvUserCreate(asynUser *pasynUser, const char* drvInfo, const char** pptypeName, size_t* psize);
     virtual asynStatus drvUserDestroy(asynUser *pasynUser);
+    virtual void report(FILE* fp, int details);
+    
+    int numBoards() const { return (int)m_boards.size(); }
+    void setScanGap(int gap);
+    void setReadTimeout(double timeout, int retries);
+    void addPollRange(int board, unsigned start, size_t nwords, double period);
+    void configBegin(int board);
+    void configStage(unsigned address, const epicsUInt32* data, size_t nwords);
+    int configCommit();
+    int dump(int board, const char* filename, unsigned start, size_t nwords);
+    void addRegisterMap(int board, const std::string& filename, unsigned base, const std::string& prefix, double period);
+    void addSnapshotRange(int board, unsigned start, size_t nwords);
+    int snapshot(int board, const std::string& filename);
+    int snapshotDiff(int board, const std::string& filename);
+    int snapshotRestore(int board, const std::string& filename, bool force);
 
 private:
 
-	DAEDataUDP* m_udp;
+	/// an I/O Intr record address, posted whenever a poll range covering it is read
+	struct PollParam
+	{
+		int param;          ///< asyn parameter the record's callbacks are made on
+		size_t nwords;
+		bool array;         ///< asynInt32Array rather than asynInt32 parameter
+		double period;      ///< scan period in seconds requested by the record
+		unsigned deadband;  ///< a word is only taken to have changed if it differs from its last posted value by more than this
+		std::vector<epicsUInt32> last;  ///< the words last posted, callbacks are only made when they change
+		asynStatus status;  ///< of the last poll posted
+		bool posted;        ///< last and status hold what was last posted
+	};
+	
+	/// a block of DAE memory the poller reads every period seconds
+	struct PollRange
+	{
+		unsigned start;
+		size_t nwords;
+		double period;
+		bool automatic;     ///< built from PollParam addresses rather than added by daedataPollRange()
+		epicsTime next_poll;
+		PollRange(unsigned start_, size_t nwords_, double period_, bool automatic_) : start(start_), nwords(nwords_), period(period_), automatic(automatic_), next_poll(epicsTime::getCurrent()) { }
+	};
+
+	/// a register map loaded for a block of a board's memory, its fields decoded whenever the poller reads the block
+	struct RegisterBlock
+	{
+		unsigned base;
+		double period;                    ///< poll period, seconds
+		DAEDataRegisterMap map;
+		std::vector<int> params;          ///< asyn parameter of each field, in map.fields() order
+		std::vector<epicsUInt32> words;   ///< the block as last decoded
+		std::vector<epicsUInt32> values;  ///< field values last posted
+		asynStatus status;                ///< of the last poll, posted on all the field parameters
+		bool decoded;                     ///< words and values hold a decoded block
+	};
+
+	/// one DAE on the port, selected by asyn address. Each has its own DAEDataUDP, and so its own
+	/// sockets, receive thread and window of reads in flight, plus its own shadow memory and poller
+	/// thread, so traffic to one board never waits behind another
+	struct Board
+	{
+		std::string host;
+		DAEDataUDP* udp;
+		std::multimap<unsigned, PollParam> poll_params;  ///< keyed on word address
+		std::vector<PollRange> poll_ranges;
+		std::vector<RegisterBlock> register_blocks;   ///< polled along with poll_params
+		std::vector< std::pair<unsigned, size_t> > snapshot_ranges;  ///< (start, nwords) added by daedataSnapshotRange()
+		bool poll_ranges_dirty;   ///< poll params have changed so automatic ranges need rebuilding
+		DAEDataShadow shadow;
+		std::vector<epicsUInt32> poll_buffer;   ///< only used by this board's poller thread
+		epicsTime next_link_update;   ///< when the poller next posts the LINK_* parameters
+		double posted;       ///< polled values and register fields posted because they changed
+		double suppressed;   ///< those polled but not posted as they had not
+		Board(const std::string& host_, DAEDataUDP* udp_) : host(host_), udp(udp_), poll_ranges_dirty(false), next_link_update(epicsTime::getCurrent()), posted(0.0), suppressed(0.0) { }
+	};
+	
+	/// argument of pollerThreadC()
+	struct PollerArg
+	{
+		daedataDriver* driver;
+		int board;
+	};
+
+	std::vector<Board*> m_boards;   ///< indexed by asyn address
+	std::map<int, unsigned> m_poll_param_address;     ///< asyn parameter -> word address for poll records
+	std::set<int> m_register_params;   ///< asyn parameters of register map fields
+	DAEDataRegisterMap::Field m_word_field;   ///< all 32 bits of a word, for masked writes to addresses without "bits="
+	int m_scan_gap;       ///< number of unused words we are prepared to read to join two addresses into one block
+	DAEDataConfig m_config;    ///< configuration transaction being staged, one per port rather than per board
+	int m_config_board;        ///< board m_config is for
+	std::vector<epicsInt32> m_config_diff;   ///< (address, written, read back) for each word of the last transaction that failed verify
+	
+	/// values of P_ConfigStatus
+	enum ConfigStatus { ConfigOK = 0, ConfigVerifyFailed = 1, ConfigError = 2 };
+	
+	DAEDataDump m_dump;    ///< only used by whoever set m_dump_running. One per port, so a dump is refused while one of any board runs, and starting one forgets where a failed dump of another board got to
+	bool m_dump_running;
+	int m_dump_board;      ///< board m_dump reads, its DUMP_* parameters are the ones posted
+	
+	/// values of P_DumpStatus
+	enum DumpStatus { DumpIdle = 0, DumpRunning = 1, DumpDone = 2, DumpFailed = 3 };
+	
+	/// posts dump progress to the DUMP_* parameters, and optionally the console
+	class DumpProgress : public DAEDataDump::Progress
+	{
+	public:
+		DumpProgress(daedataDriver* driver, bool print) : m_driver(driver), m_print(print), m_percent(0) { }
+		virtual void progress(size_t done, size_t total, double rate);
+	private:
+		daedataDriver* m_driver;
+		bool m_print;
+		int m_percent;   ///< last percentage printed
+	};
 	
 	int P_Address; // int
 	int P_AddressW; // int
 	int P_AddressR; // int
+	int P_CacheHits; // int
+	int P_CacheMisses; // int
+	int P_CacheAge; // int, milliseconds
+	int P_CacheWords; // int
+	int P_ConfigUpload; // int array
+	int P_ConfigStatus; // int
+	int P_ConfigMismatches; // int
+	int P_ConfigDatagrams; // int
+	int P_ConfigDiff; // int array
+	int P_DumpFile; // string
+	int P_DumpStart; // int
+	int P_DumpWords; // int
+	int P_Dump; // int, write to start a dump
+	int P_DumpStatus; // int
+	int P_DumpDone; // int, words
+	int P_DumpRate; // double, MB/s
+	int P_LinkReads; // double, datagrams
+	int P_LinkReadBytes; // double
+	int P_LinkRetransmits; // double
+	int P_LinkTimeouts; // double
+	int P_LinkStale; // double
+	int P_LinkSizeErrors; // double
+	int P_LinkWrites; // double, datagrams
+	int P_LinkWriteBytes; // double
+	int P_LinkSendErrors; // double
+	int P_LinkVerifyRereads; // double
+	int P_LinkVerifyFailures; // double
+	int P_LinkRTTHist; // double array, replies per round trip time bucket
+	int P_LinkRTTLimits; // double array, ms
+	int P_LinkRTT; // double, ms
+	int P_LinkRTO; // double, ms
+	int P_LinkUp; // int, 0 while the board is not answering
+	int P_LinkRejected; // double
+	int P_PollPosted; // double, values posted to I/O Intr records
+	int P_PollSuppressed; // double, values polled but unchanged
 
 	#define FIRST_ISISDAE_PARAM P_Address
-	#define LAST_ISISDAE_PARAM P_AddressR
+	#define LAST_ISISDAE_PARAM P_PollSuppressed
 	
-	void pollerThread();
+	void pollerThread(int board);
+	bool isAddressParam(int function) const { return (function == P_Address || m_poll_param_address.count(function) > 0); }
+	int boardIndex(asynUser *pasynUser);
+	std::string paramPoolError(const std::string& name) const;
+	int addPollParam(const std::string& key, int board, unsigned address, size_t nwords, double period, unsigned deadband);
+	void buildPollRanges(Board& b);
+	void pollRanges(int board, const std::vector<PollRange>& ranges);
+	void publishRange(int board, unsigned start, epicsUInt32* data, size_t nwords, asynStatus status);
+	void decodeRegisters(int board, unsigned start, const epicsUInt32* data, size_t nwords, asynStatus status);
+	void decodeBlock(int board, RegisterBlock& rb, const epicsUInt32* words);
+	RegisterBlock* findRegisterField(int board, int param, size_t& field);
+	void publishLink(int board);
+	void readMemory(asynUser *pasynUser, int board, const DAEDataAddress& addr, epicsUInt32* data, size_t nwords);
+	asynStatus uploadConfig(asynUser *pasynUser, const epicsUInt32* value, size_t nElements);
+	asynStatus commitConfig(asynUser *pasynUser);
+	void writeMemory(asynUser *pasynUser, int board, const DAEDataAddress& addr, const epicsUInt32* data, size_t nwords);
+	epicsUInt32 readField(asynUser *pasynUser, int board, const DAEDataAddress& addr);
+	void writeField(asynUser *pasynUser, int board, unsigned base, const DAEDataRegisterMap::Field& field, epicsUInt32 value, epicsUInt32 mask, bool verify, std::vector<epicsUInt32>& words);
+	asynStatus readBits(asynUser *pasynUser, const char* functionName, epicsUInt32* value, epicsUInt32 mask);
+	asynStatus writeBits(asynUser *pasynUser, const char* functionName, epicsUInt32 value, epicsUInt32 mask, bool whole);
+	bool isFieldParam(asynUser *pasynUser) const;
+	void dumpThread();
+	int runDump(const std::string& filename, unsigned start, size_t nwords, bool print);
+	void snapshotRanges(int board, DAEDataSnapshot& snap);
+	bool checkSnapshot(const char* func, int board, const DAEDataSnapshot& snap, const epicsUInt32* firmware);
 	
 	template<typename T> asynStatus writeValue(asynUser *pasynUser, const char* functionName, T value);
     template<typename T> asynStatus readValue(asynUser *pasynUser, const char* functionName, T* value);
@@ -43,9 +225,45 @@ private:
 };
 
 #define NUM_ISISDAE_PARAMS (&LAST_ISISDAE_PARAM - &FIRST_ISISDAE_PARAM + 1)
+#define MAX_ADDRESS_PARAMS 2000  ///< parameters created on demand for polled addresses and register map fields
 
 #define P_AddressString					"ADDRESS"
 #define P_AddressWString				"ADDRESS_W"
 #define P_AddressRString				"ADDRESS_R"
+#define P_CacheHitsString				"CACHE_HITS"
+#define P_CacheMissesString				"CACHE_MISSES"
+#define P_CacheAgeString				"CACHE_AGE"
+#define P_CacheWordsString				"CACHE_WORDS"
+#define P_ConfigUploadString			"CONFIG_UPLOAD"
+#define P_ConfigStatusString			"CONFIG_STATUS"
+#define P_ConfigMismatchesString		"CONFIG_MISMATCHES"
+#define P_ConfigDatagramsString			"CONFIG_DATAGRAMS"
+#define P_ConfigDiffString				"CONFIG_DIFF"
+#define P_DumpFileString				"DUMP_FILE"
+#define P_DumpStartString				"DUMP_START"
+#define P_DumpWordsString				"DUMP_NWORDS"
+#define P_DumpString					"DUMP"
+#define P_DumpStatusString				"DUMP_STATUS"
+#define P_DumpDoneString				"DUMP_DONE"
+#define P_DumpRateString				"DUMP_RATE"
+#define P_LinkReadsString				"LINK_READS"
+#define P_LinkReadBytesString			"LINK_READ_BYTES"
+#define P_LinkRetransmitsString			"LINK_RETRANSMITS"
+#define P_LinkTimeoutsString			"LINK_TIMEOUTS"
+#define P_LinkStaleString				"LINK_STALE"
+#define P_LinkSizeErrorsString			"LINK_SIZE_ERRORS"
+#define P_LinkWritesString				"LINK_WRITES"
+#define P_LinkWriteBytesString			"LINK_WRITE_BYTES"
+#define P_LinkSendErrorsString			"LINK_SEND_ERRORS"
+#define P_LinkVerifyRereadsString		"LINK_VERIFY_REREADS"
+#define P_LinkVerifyFailuresString		"LINK_VERIFY_FAILURES"
+#define P_LinkRTTHistString				"LINK_RTT_HIST"
+#define P_LinkRTTLimitsString			"LINK_RTT_LIMITS"
+#define P_LinkRTTString					"LINK_RTT"
+#define P_LinkRTOString					"LINK_RTO"
+#define P_LinkUpString					"LINK_UP"
+#define P_LinkRejectedString			"LINK_REJECTED"
+#define P_PollPostedString				"POLL_POSTED"
+#define P_PollSuppressedString			"POLL_SUPPRESSED"
 
 #endif /* DAEDATADRIVER_H */
@@ -0,0 +1,228 @@
+#include <string>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif /* _WIN32 */
+
+#include <epicsTypes.h>
+#include <epicsTime.h>
+
+#include "asynDriver.h"
+
+#include "daedataDump.h"
+
+#define DUMP_CHUNK_WORDS 65536  ///< words per mapped window and per batch of reads, 256kB keeps windows aligned to the Windows 64kB allocation granularity
+
+DAEDataDump::DAEDataDump() : m_start(0), m_nwords(0), m_done(0), m_rate(0.0),
+#ifdef _WIN32
+    m_file(INVALID_HANDLE_VALUE), m_mapping(NULL)
+#else
+    m_fd(-1), m_mapped_words(0)
+#endif
+{
+}
+
+DAEDataDump::~DAEDataDump()
+{
+    closeFile();
+}
+
+/// set up a dump of nwords words from DAE address start to filename
+/// \return true if this carries on from a previous failed dump of the same region to the same file
+bool DAEDataDump::prepare(const std::string& filename, unsigned start, size_t nwords)
+{
+    if (filename == m_filename && start == m_start && nwords == m_nwords && m_done > 0 && !complete())
+    {
+        return true;
+    }
+    m_filename = filename;
+    m_start = start;
+    m_nwords = nwords;
+    m_done = 0;
+    m_rate = 0.0;
+    return false;
+}
+
+/// read the region into the file from the last completed chunk onwards. A failed chunk is retried
+/// from its start up to retries times in a row before giving up, leaving done() at the failed chunk
+void DAEDataDump::run(DAEDataUDP* udp, asynUser* pasynUser, Progress* progress, int retries)
+{
+    epicsTime start_time = epicsTime::getCurrent();
+    size_t start_done = m_done;
+    int failures = 0;
+    openFile(m_done > 0);
+    try
+    {
+        while(m_done < m_nwords)
+        {
+            size_t n = std::min((size_t)DUMP_CHUNK_WORDS, m_nwords - m_done);
+            epicsUInt32* data = mapChunk(m_done, n);
+            try
+            {
+                udp->readData(m_start + 4 * (unsigned)m_done, data, n, pasynUser);
+            }
+            catch(const std::exception& ex)
+            {
+                unmapChunk(data);
+                if (++failures > retries)
+                {
+                    throw;
+                }
+                asynPrint(pasynUser, ASYN_TRACE_ERROR, "DAEDataDump: retrying from address 0x%x: %s\n", m_start + 4 * (unsigned)m_done, ex.what());
+                continue;
+            }
+            unmapChunk(data);
+            failures = 0;
+            m_done += n;
+            double elapsed = epicsTime::getCurrent() - start_time;
+            m_rate = (elapsed > 0.0 ? 4.0 * (m_done - start_done) / elapsed / 1e6 : 0.0);
+            if (progress != NULL)
+            {
+                progress->progress(m_done, m_nwords, m_rate);
+            }
+        }
+    }
+    catch(...)
+    {
+        closeFile();
+        throw;
+    }
+    closeFile();
+}
+
+#ifdef _WIN32
+
+/// create (or when resuming reopen) the output file at its full size
+void DAEDataDump::openFile(bool resume)
+{
+    std::ostringstream error_message;
+    unsigned long long size = 4ULL * m_nwords;
+    m_file = CreateFileA(m_filename.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, (resume ? OPEN_ALWAYS : CREATE_ALWAYS), FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        error_message << "DAEDataDump: cannot create \"" << m_filename << "\": error " << GetLastError();
+        throw std::runtime_error(error_message.str());
+    }
+    m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, NULL);
+    if (m_mapping == NULL)
+    {
+        error_message << "DAEDataDump: cannot map \"" << m_filename << "\": error " << GetLastError();
+        closeFile();
+        throw std::runtime_error(error_message.str());
+    }
+}
+
+void DAEDataDump::closeFile()
+{
+    if (m_mapping != NULL)
+    {
+        CloseHandle(m_mapping);
+        m_mapping = NULL;
+    }
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+}
+
+/// map the part of the file for nwords words from word offset
+epicsUInt32* DAEDataDump::mapChunk(size_t offset, size_t nwords)
+{
+    std::ostringstream error_message;
+    unsigned long long pos = 4ULL * offset;
+    void* data = MapViewOfFile(m_mapping, FILE_MAP_WRITE, (DWORD)(pos >> 32), (DWORD)pos, 4 * nwords);
+    if (data == NULL)
+    {
+        error_message << "DAEDataDump: cannot map view of \"" << m_filename << "\": error " << GetLastError();
+        throw std::runtime_error(error_message.str());
+    }
+    return (epicsUInt32*)data;
+}
+
+void DAEDataDump::unmapChunk(epicsUInt32* data)
+{
+    UnmapViewOfFile(data);
+}
+
+#else
+
+/// create (or when resuming reopen) the output file at its full size, with the disk space for the words 
+/// still to be read allocated, as writing through a mapping into a hole on a full disk raises SIGBUS
+void DAEDataDump::openFile(bool resume)
+{
+    std::ostringstream error_message;
+    int stat = 0;
+    m_fd = open(m_filename.c_str(), O_RDWR | O_CREAT | (resume ? 0 : O_TRUNC), 0644);
+    if (m_fd < 0)
+    {
+        error_message << "DAEDataDump: cannot create \"" << m_filename << "\": " << strerror(errno);
+        throw std::runtime_error(error_message.str());
+    }
+    if (ftruncate(m_fd, (off_t)(4 * m_nwords)) != 0)
+    {
+        error_message << "DAEDataDump: cannot size \"" << m_filename << "\": " << strerror(errno);
+        closeFile();
+        throw std::runtime_error(error_message.str());
+    }
+#ifdef __APPLE__
+    // no posix_fallocate(), write zeros instead
+    static const char zeros[4096] = { 0 };
+    for(off_t pos = (off_t)(4 * m_done); pos < (off_t)(4 * m_nwords) && stat == 0; pos += sizeof(zeros))
+    {
+        size_t n = std::min(sizeof(zeros), (size_t)((off_t)(4 * m_nwords) - pos));
+        if (pwrite(m_fd, zeros, n, pos) != (ssize_t)n)
+        {
+            stat = (errno != 0 ? errno : ENOSPC);
+        }
+    }
+#else
+    stat = posix_fallocate(m_fd, (off_t)(4 * m_done), (off_t)(4 * (m_nwords - m_done)));
+#endif
+    if (stat != 0)
+    {
+        error_message << "DAEDataDump: cannot allocate " << 4 * (m_nwords - m_done) << " bytes for \"" << m_filename << "\": " << strerror(stat);
+        closeFile();
+        throw std::runtime_error(error_message.str());
+    }
+}
+
+void DAEDataDump::closeFile()
+{
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+/// map the part of the file for nwords words from word offset
+epicsUInt32* DAEDataDump::mapChunk(size_t offset, size_t nwords)
+{
+    std::ostringstream error_message;
+    void* data = mmap(NULL, 4 * nwords, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, (off_t)(4 * offset));
+    if (data == MAP_FAILED)
+    {
+        error_message << "DAEDataDump: cannot map \"" << m_filename << "\": " << strerror(errno);
+        throw std::runtime_error(error_message.str());
+    }
+    m_mapped_words = nwords;
+    return (epicsUInt32*)data;
+}
+
+void DAEDataDump::unmapChunk(epicsUInt32* data)
+{
+    munmap(data, 4 * m_mapped_words);
+}
+
+#endif /* _WIN32 */
@@ -0,0 +1,56 @@
+#ifndef DAEDATADUMP_H
+#define DAEDATADUMP_H
+
+#include <string>
+
+#include <epicsTypes.h>
+
+#include "daedataUDP.h"
+
+/// Streams a DAE memory region into a file of host order 32 bit words, e.g. histogram memory or a
+/// DSP setup bank for diagnostics. The file is written through a memory mapped window one chunk at a
+/// time, each chunk filled directly by pipelined block reads, so no large heap buffer is needed.
+/// The file's disk space is allocated up front, so a full disk fails the dump when it starts rather 
+/// than faulting a write through the mapping part way through.
+/// A dump that fails (e.g. times out) remembers how many chunks completed, and a later run of the
+/// same region to the same file carries on from there. Not thread safe, the owner serialises access
+class DAEDataDump
+{
+public:
+    /// told about each chunk as it completes
+    class Progress
+    {
+    public:
+        virtual void progress(size_t done, size_t total, double rate) = 0;
+        virtual ~Progress() { }
+    };
+
+    DAEDataDump();
+    ~DAEDataDump();
+    bool prepare(const std::string& filename, unsigned start, size_t nwords);
+    void run(DAEDataUDP* udp, asynUser* pasynUser, Progress* progress, int retries);
+    size_t done() const { return m_done; }
+    size_t total() const { return m_nwords; }
+    bool complete() const { return m_nwords > 0 && m_done == m_nwords; }
+    double rate() const { return m_rate; }
+
+private:
+    std::string m_filename;
+    unsigned m_start;       ///< DAE address of the first word
+    size_t m_nwords;
+    size_t m_done;          ///< words written so far, always a whole number of chunks unless complete
+    double m_rate;          ///< MB/s of the last run
+#ifdef _WIN32
+    void* m_file;           ///< HANDLE
+    void* m_mapping;        ///< HANDLE
+#else
+    int m_fd;
+    size_t m_mapped_words;  ///< size of the window mapChunk() last mapped
+#endif
+    void openFile(bool resume);
+    void closeFile();
+    epicsUInt32* mapChunk(size_t offset, size_t nwords);
+    void unmapChunk(epicsUInt32* data);
+};
+
+#endif /* DAEDATADUMP_H */
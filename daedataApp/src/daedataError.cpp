@@ -0,0 +1,60 @@
+#include <cstdio>
+#include <cstring>
+
+#include <osiSock.h>
+#include <epicsStdio.h>
+
+#include "daedataError.h"
+
+/// for SendFailed and WriteSendFailed the socket error is taken now, so construct the error straight after the failing call
+DAEDataError::DAEDataError(Code code_, unsigned address_, unsigned long expected_, unsigned long actual_) : 
+    code(code_), address(address_), expected(expected_), actual(actual_), sys_errno(0)
+{
+    m_sys_message[0] = m_message[0] = '\0';
+    if (code == SendFailed || code == WriteSendFailed)
+    {
+        sys_errno = SOCKERRNO;
+        epicsSocketConvertErrnoToString(m_sys_message, sizeof(m_sys_message));
+    }
+}
+
+const char* DAEDataError::what() const throw()
+{
+    switch(code)
+    {
+    case BlockSize:
+        epicsSnprintf(m_message, sizeof(m_message), "DAEDataUDP: Block size error %lu", actual);
+        break;
+    case WriteBlockSize:
+        epicsSnprintf(m_message, sizeof(m_message), "DAEDataUDP: Block size error");
+        break;
+    case SendFailed:
+        epicsSnprintf(m_message, sizeof(m_message), "DAEDataUDP: cannot send: %s", m_sys_message);
+        break;
+    case WriteSendFailed:
+        epicsSnprintf(m_message, sizeof(m_message), "DAEDataUDP: cannot sendto: %s", m_sys_message);
+        break;
+    case SendSize:
+        epicsSnprintf(m_message, sizeof(m_message), "DAEDataUDP: send size error: %lu != %lu", actual, expected);
+        break;
+    case WriteSendSize:
+        epicsSnprintf(m_message, sizeof(m_message), "DAEDataUDP: sendto size error");
+        break;
+    case ReplySize:
+        epicsSnprintf(m_message, sizeof(m_message), "DAEDataUDP: recvfrom incorrect size: %lu != %lu for address 0x%x", actual, expected, address);
+        break;
+    case Timeout:
+        epicsSnprintf(m_message, sizeof(m_message), "DAEDataUDP: timeout reading address 0x%x", address);
+        break;
+    case VerifyFailed:
+        epicsSnprintf(m_message, sizeof(m_message), "DAEDataUDP: Verify failed for address 0x%x: 0x%lx != 0x%lx", address, expected, actual);
+        break;
+    case LinkDown:
+        epicsSnprintf(m_message, sizeof(m_message), "DAEDataUDP: link down, request for address 0x%x rejected", address);
+        break;
+    default:
+        epicsSnprintf(m_message, sizeof(m_message), "DAEDataUDP: error %d at address 0x%x", (int)code, address);
+        break;
+    }
+    return m_message;
+}
@@ -0,0 +1,42 @@
+#ifndef DAEDATAERROR_H
+#define DAEDATAERROR_H
+
+#include <exception>
+
+/// a failure talking to the DAE. Carries what went wrong as fields rather than text, the message
+/// is only formatted if what() is called, and into a buffer in the object so that needs no allocation.
+/// The buffer is bounded and belongs to the exception rather than to the thread: it is as allocation free and
+/// race free as a per-thread one, but what() stays valid for as long as the exception does, whereas a
+/// thread's buffer would be overwritten by the next error that thread formatted (e.g. one caught while
+/// handling another). The per transport part of the error state is DAEDataUDP::LinkState
+class DAEDataError : public std::exception
+{
+public:
+    enum Code
+    {
+        BlockSize,       ///< asked to read actual words, the protocol allows 1 to expected per datagram
+        SendFailed,      ///< the read socket would not send, see sys_errno
+        SendSize,        ///< the read socket sent actual bytes of a datagram of expected
+        ReplySize,       ///< a reply of actual bytes arrived for a read expecting expected
+        Timeout,         ///< no reply to a read after all its retries
+        VerifyFailed,    ///< a word read back as actual after expected was written
+        LinkDown,        ///< not sent, as the board has stopped answering (see DAEDataUDP::LinkState)
+        WriteBlockSize,  ///< as BlockSize, SendFailed and SendSize for writes, which have always been reported in their own words
+        WriteSendFailed,
+        WriteSendSize
+    };
+    DAEDataError(Code code, unsigned address = 0, unsigned long expected = 0, unsigned long actual = 0);
+    virtual const char* what() const throw();
+
+    Code code;
+    unsigned address;         ///< DAE byte address of the transfer, or the word that failed verify
+    unsigned long expected;
+    unsigned long actual;
+    int sys_errno;            ///< socket error number for SendFailed and WriteSendFailed, else 0
+
+private:
+    char m_sys_message[128];      ///< the socket error as text, taken when the error happened
+    mutable char m_message[256];  ///< filled in by what()
+};
+
+#endif /* DAEDATAERROR_H */
@@ -0,0 +1,356 @@
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+#include <epicsThread.h>
+
+#include "daedataKernels.h"
+
+#if !defined(DAEDATA_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define DAEDATA_HAVE_SSE2
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define DAEDATA_TARGET_SSSE3
+#else
+#define DAEDATA_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#endif
+
+// The scalar kernels work a byte at a time so are correct whatever the host byte order,
+// and also finish off the last few words the vector kernels leave
+
+static void scalar_decode32(const void* wire, void* host, size_t nwords, uint32_t offset)
+{
+    const uint8_t* b = (const uint8_t*)wire;
+    uint32_t* h = (uint32_t*)host;
+    for(size_t i=0; i<nwords; ++i, b += 4)
+    {
+        h[i] = (((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3]) + offset;
+    }
+}
+
+static void scalar_decodeHalvesHigh(const void* wire, void* host, size_t nwords, uint32_t offset)
+{
+    const uint8_t* b = (const uint8_t*)wire;
+    uint16_t* h = (uint16_t*)host;
+    for(size_t i=0; i<nwords; ++i, b += 4)
+    {
+        h[2 * i] = (uint16_t)(((b[0] << 8) | b[1]) + offset);
+        h[2 * i + 1] = (uint16_t)(((b[2] << 8) | b[3]) + offset);
+    }
+}
+
+static void scalar_decodeHalvesLow(const void* wire, void* host, size_t nwords, uint32_t offset)
+{
+    const uint8_t* b = (const uint8_t*)wire;
+    uint16_t* h = (uint16_t*)host;
+    for(size_t i=0; i<nwords; ++i, b += 4)
+    {
+        h[2 * i] = (uint16_t)(((b[2] << 8) | b[3]) + offset);
+        h[2 * i + 1] = (uint16_t)(((b[0] << 8) | b[1]) + offset);
+    }
+}
+
+static void scalar_decodeLow16(const void* wire, void* host, size_t nwords, uint32_t offset)
+{
+    const uint8_t* b = (const uint8_t*)wire;
+    uint16_t* h = (uint16_t*)host;
+    for(size_t i=0; i<nwords; ++i, b += 4)
+    {
+        h[i] = (uint16_t)(((b[2] << 8) | b[3]) + offset);
+    }
+}
+
+static void scalar_encode32(const void* host, void* wire, size_t nwords, uint32_t offset)
+{
+    const uint32_t* h = (const uint32_t*)host;
+    uint8_t* b = (uint8_t*)wire;
+    for(size_t i=0; i<nwords; ++i, b += 4)
+    {
+        uint32_t w = h[i] - offset;
+        b[0] = (uint8_t)(w >> 24);
+        b[1] = (uint8_t)(w >> 16);
+        b[2] = (uint8_t)(w >> 8);
+        b[3] = (uint8_t)w;
+    }
+}
+
+static void scalar_encodeHalvesHigh(const void* host, void* wire, size_t nwords, uint32_t offset)
+{
+    const uint16_t* h = (const uint16_t*)host;
+    uint8_t* b = (uint8_t*)wire;
+    for(size_t i=0; i<nwords; ++i, b += 4)
+    {
+        uint16_t hi = (uint16_t)(h[2 * i] - offset), lo = (uint16_t)(h[2 * i + 1] - offset);
+        b[0] = (uint8_t)(hi >> 8);
+        b[1] = (uint8_t)hi;
+        b[2] = (uint8_t)(lo >> 8);
+        b[3] = (uint8_t)lo;
+    }
+}
+
+static void scalar_encodeHalvesLow(const void* host, void* wire, size_t nwords, uint32_t offset)
+{
+    const uint16_t* h = (const uint16_t*)host;
+    uint8_t* b = (uint8_t*)wire;
+    for(size_t i=0; i<nwords; ++i, b += 4)
+    {
+        uint16_t lo = (uint16_t)(h[2 * i] - offset), hi = (uint16_t)(h[2 * i + 1] - offset);
+        b[0] = (uint8_t)(hi >> 8);
+        b[1] = (uint8_t)hi;
+        b[2] = (uint8_t)(lo >> 8);
+        b[3] = (uint8_t)lo;
+    }
+}
+
+static void scalar_encodeLow16(const void* host, void* wire, size_t nwords, uint32_t offset)
+{
+    const uint16_t* h = (const uint16_t*)host;
+    uint8_t* b = (uint8_t*)wire;
+    for(size_t i=0; i<nwords; ++i, b += 4)
+    {
+        uint16_t lo = (uint16_t)(h[i] - offset);
+        b[0] = 0;
+        b[1] = 0;
+        b[2] = (uint8_t)(lo >> 8);
+        b[3] = (uint8_t)lo;
+    }
+}
+
+static const DAEDataKernels scalar_kernels = { "scalar",
+    { scalar_decode32, scalar_decodeHalvesHigh, scalar_decodeHalvesLow, scalar_decodeLow16 },
+    { scalar_encode32, scalar_encodeHalvesHigh, scalar_encodeHalvesLow, scalar_encodeLow16 } };
+
+#ifdef DAEDATA_HAVE_SSE2
+
+// x86 is little endian, so a 32 bit swap of a big endian word leaves its low half first in memory
+// and a 16 bit swap leaves its high half first. Each kernel does 16 bytes of datagram per step,
+// ISA##_swap16() and ISA##_swap32() provide the byte shuffles for each instruction set
+
+#define DAEDATA_SIMD_KERNELS(ISA, TARGET) \
+static TARGET void ISA##_decode32(const void* wire, void* host, size_t nwords, uint32_t offset) \
+{ \
+    const __m128i* w = (const __m128i*)wire; \
+    __m128i* h = (__m128i*)host; \
+    __m128i off = _mm_set1_epi32((int)offset); \
+    size_t n = nwords / 4; \
+    for(size_t i=0; i<n; ++i) \
+    { \
+        _mm_storeu_si128(h + i, _mm_add_epi32(ISA##_swap32(_mm_loadu_si128(w + i)), off)); \
+    } \
+    scalar_decode32(w + n, h + n, nwords - 4 * n, offset); \
+} \
+static TARGET void ISA##_decodeHalvesHigh(const void* wire, void* host, size_t nwords, uint32_t offset) \
+{ \
+    const __m128i* w = (const __m128i*)wire; \
+    __m128i* h = (__m128i*)host; \
+    __m128i off = _mm_set1_epi16((short)offset); \
+    size_t n = nwords / 4; \
+    for(size_t i=0; i<n; ++i) \
+    { \
+        _mm_storeu_si128(h + i, _mm_add_epi16(ISA##_swap16(_mm_loadu_si128(w + i)), off)); \
+    } \
+    scalar_decodeHalvesHigh(w + n, h + n, nwords - 4 * n, offset); \
+} \
+static TARGET void ISA##_decodeHalvesLow(const void* wire, void* host, size_t nwords, uint32_t offset) \
+{ \
+    const __m128i* w = (const __m128i*)wire; \
+    __m128i* h = (__m128i*)host; \
+    __m128i off = _mm_set1_epi16((short)offset); \
+    size_t n = nwords / 4; \
+    for(size_t i=0; i<n; ++i) \
+    { \
+        _mm_storeu_si128(h + i, _mm_add_epi16(ISA##_swap32(_mm_loadu_si128(w + i)), off)); \
+    } \
+    scalar_decodeHalvesLow(w + n, h + n, nwords - 4 * n, offset); \
+} \
+static TARGET void ISA##_decodeLow16(const void* wire, void* host, size_t nwords, uint32_t offset) \
+{ \
+    const __m128i* w = (const __m128i*)wire; \
+    __m128i* h = (__m128i*)host; \
+    __m128i off = _mm_set1_epi16((short)offset); \
+    size_t n = nwords / 8; \
+    for(size_t i=0; i<n; ++i) \
+    { \
+        __m128i a = ISA##_swap32(_mm_loadu_si128(w + 2 * i)); \
+        __m128i b = ISA##_swap32(_mm_loadu_si128(w + 2 * i + 1)); \
+        a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16); \
+        b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16); \
+        _mm_storeu_si128(h + i, _mm_add_epi16(_mm_packs_epi32(a, b), off)); \
+    } \
+    scalar_decodeLow16(w + 2 * n, h + n, nwords - 8 * n, offset); \
+} \
+static TARGET void ISA##_encode32(const void* host, void* wire, size_t nwords, uint32_t offset) \
+{ \
+    const __m128i* h = (const __m128i*)host; \
+    __m128i* w = (__m128i*)wire; \
+    __m128i off = _mm_set1_epi32((int)offset); \
+    size_t n = nwords / 4; \
+    for(size_t i=0; i<n; ++i) \
+    { \
+        _mm_storeu_si128(w + i, ISA##_swap32(_mm_sub_epi32(_mm_loadu_si128(h + i), off))); \
+    } \
+    scalar_encode32(h + n, w + n, nwords - 4 * n, offset); \
+} \
+static TARGET void ISA##_encodeHalvesHigh(const void* host, void* wire, size_t nwords, uint32_t offset) \
+{ \
+    const __m128i* h = (const __m128i*)host; \
+    __m128i* w = (__m128i*)wire; \
+    __m128i off = _mm_set1_epi16((short)offset); \
+    size_t n = nwords / 4; \
+    for(size_t i=0; i<n; ++i) \
+    { \
+        _mm_storeu_si128(w + i, ISA##_swap16(_mm_sub_epi16(_mm_loadu_si128(h + i), off))); \
+    } \
+    scalar_encodeHalvesHigh(h + n, w + n, nwords - 4 * n, offset); \
+} \
+static TARGET void ISA##_encodeHalvesLow(const void* host, void* wire, size_t nwords, uint32_t offset) \
+{ \
+    const __m128i* h = (const __m128i*)host; \
+    __m128i* w = (__m128i*)wire; \
+    __m128i off = _mm_set1_epi16((short)offset); \
+    size_t n = nwords / 4; \
+    for(size_t i=0; i<n; ++i) \
+    { \
+        _mm_storeu_si128(w + i, ISA##_swap32(_mm_sub_epi16(_mm_loadu_si128(h + i), off))); \
+    } \
+    scalar_encodeHalvesLow(h + n, w + n, nwords - 4 * n, offset); \
+} \
+static TARGET void ISA##_encodeLow16(const void* host, void* wire, size_t nwords, uint32_t offset) \
+{ \
+    const __m128i* h = (const __m128i*)host; \
+    __m128i* w = (__m128i*)wire; \
+    __m128i off = _mm_set1_epi16((short)offset); \
+    __m128i zero = _mm_setzero_si128(); \
+    size_t n = nwords / 8; \
+    for(size_t i=0; i<n; ++i) \
+    { \
+        __m128i v = _mm_sub_epi16(_mm_loadu_si128(h + i), off); \
+        _mm_storeu_si128(w + 2 * i, ISA##_swap32(_mm_unpacklo_epi16(v, zero))); \
+        _mm_storeu_si128(w + 2 * i + 1, ISA##_swap32(_mm_unpackhi_epi16(v, zero))); \
+    } \
+    scalar_encodeLow16(h + n, w + 2 * n, nwords - 8 * n, offset); \
+} \
+static const DAEDataKernels ISA##_kernels = { #ISA, \
+    { ISA##_decode32, ISA##_decodeHalvesHigh, ISA##_decodeHalvesLow, ISA##_decodeLow16 }, \
+    { ISA##_encode32, ISA##_encodeHalvesHigh, ISA##_encodeHalvesLow, ISA##_encodeLow16 } };
+
+// SSE2 has no byte shuffle, so swap bytes within 16 bit lanes with shifts then swap the lanes
+
+static inline __m128i sse2_swap16(__m128i v)
+{
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+static inline __m128i sse2_swap32(__m128i v)
+{
+    v = sse2_swap16(v);
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+DAEDATA_SIMD_KERNELS(sse2, )
+
+static inline DAEDATA_TARGET_SSSE3 __m128i ssse3_swap16(__m128i v)
+{
+    return _mm_shuffle_epi8(v, _mm_set_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1));
+}
+
+static inline DAEDATA_TARGET_SSSE3 __m128i ssse3_swap32(__m128i v)
+{
+    return _mm_shuffle_epi8(v, _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3));
+}
+
+DAEDATA_SIMD_KERNELS(ssse3, DAEDATA_TARGET_SSSE3)
+
+static bool cpuHasSSSE3()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#elif defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3") != 0;
+#else
+    return false;
+#endif
+}
+
+#endif /* DAEDATA_HAVE_SSE2 */
+
+/// compiled in kernels, slowest first
+static const DAEDataKernels* const all_kernels[] = {
+    &scalar_kernels
+#ifdef DAEDATA_HAVE_SSE2
+    , &sse2_kernels, &ssse3_kernels
+#endif
+};
+
+static const size_t num_kernels = sizeof(all_kernels) / sizeof(all_kernels[0]);
+
+static const DAEDataKernels* selected_kernels = &scalar_kernels;
+
+static epicsThreadOnceId kernels_once = EPICS_THREAD_ONCE_INIT;
+
+static bool kernelsSupported(const DAEDataKernels* kernels)
+{
+#ifdef DAEDATA_HAVE_SSE2
+    if (kernels == &ssse3_kernels)
+    {
+        return cpuHasSSSE3();
+    }
+#endif
+    return true;
+}
+
+const DAEDataKernels* daedataKernelsAt(size_t i)
+{
+    for(size_t j=0; j<num_kernels; ++j)
+    {
+        if (kernelsSupported(all_kernels[j]) && i-- == 0)
+        {
+            return all_kernels[j];
+        }
+    }
+    return NULL;
+}
+
+const DAEDataKernels* daedataFindKernels(const char* name)
+{
+    const DAEDataKernels* kernels = NULL;
+    for(size_t i=0; daedataKernelsAt(i) != NULL; ++i)
+    {
+        if (name == NULL || *name == '\0' || !strcmp(name, "auto") || !strcmp(name, daedataKernelsAt(i)->name))
+        {
+            kernels = daedataKernelsAt(i);
+        }
+    }
+    return kernels;
+}
+
+static void initKernels(void*)
+{
+    const char* name = getenv("DAEDATA_KERNELS");
+    const DAEDataKernels* kernels = daedataFindKernels(name);
+    selected_kernels = (kernels != NULL ? kernels : daedataFindKernels("auto"));
+}
+
+const DAEDataKernels& daedataKernels()
+{
+    epicsThreadOnce(&kernels_once, initKernels, NULL);
+    return *selected_kernels;
+}
+
+bool daedataSelectKernels(const char* name)
+{
+    epicsThreadOnce(&kernels_once, initKernels, NULL);
+    const DAEDataKernels* kernels = daedataFindKernels(name);
+    if (kernels == NULL)
+    {
+        return false;
+    }
+    selected_kernels = kernels;
+    return true;
+}
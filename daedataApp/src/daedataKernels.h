@@ -0,0 +1,47 @@
+#ifndef DAEDATAKERNELS_H
+#define DAEDATAKERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// How DAE words are laid out in a host buffer. DAE words are always big endian in the datagrams
+enum DAEDataLayout
+{
+    DAEDataLayout32 = 0,       ///< one host order 32 bit word per word
+    DAEDataLayoutHalvesHigh,   ///< two 16 bit elements per word, high half first
+    DAEDataLayoutHalvesLow,    ///< two 16 bit elements per word, low half first
+    DAEDataLayoutLow16,        ///< one 16 bit element per word, the low half (the high half is zero when encoding)
+    DAEDataNumLayouts
+};
+
+/// convert nwords big endian DAE words at wire to a host buffer, adding offset to each element
+typedef void (*DAEDataDecodeFn)(const void* wire, void* host, size_t nwords, uint32_t offset);
+
+/// convert a host buffer to nwords big endian DAE words at wire, subtracting offset from each element
+typedef void (*DAEDataEncodeFn)(const void* host, void* wire, size_t nwords, uint32_t offset);
+
+/// One implementation of the datagram payload conversions, each a single pass that fuses the byte swap,
+/// the 16/32 bit unpack and the offset. For 16 bit layouts only the low 16 bits of offset are used, so 
+/// an offset of 0x8000 converts between offset binary and two's complement.
+struct DAEDataKernels
+{
+    const char* name;
+    DAEDataDecodeFn decode[DAEDataNumLayouts];
+    DAEDataEncodeFn encode[DAEDataNumLayouts];
+};
+
+/// kernels in use, chosen on first call as the fastest the CPU supports unless the DAEDATA_KERNELS
+/// environment variable names another set. Building with DAEDATA_NO_SIMD defined leaves only "scalar"
+const DAEDataKernels& daedataKernels();
+
+/// switch to the named kernels ("scalar", "sse2", "ssse3" or "auto")
+/// \return false if they are not compiled in or not supported by this CPU
+bool daedataSelectKernels(const char* name);
+
+/// \return the kernels with this name if they can be used on this CPU, otherwise NULL
+const DAEDataKernels* daedataFindKernels(const char* name);
+
+/// \return the i'th compiled in kernel set supported by this CPU, NULL past the end
+const DAEDataKernels* daedataKernelsAt(size_t i);
+
+#endif /* DAEDATAKERNELS_H */
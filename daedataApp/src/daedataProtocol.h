@@ -0,0 +1,46 @@
+#ifndef DAEDATAPROTOCOL_H
+#define DAEDATAPROTOCOL_H
+
+/// The DAE memory access protocol, shared by DAEDataUDP and the daedataSim simulator.
+/// A read_send datagram to DAE_READ_PORT is answered by a read_recv datagram with the same start
+/// address and block size; a write_send datagram to DAE_WRITE_PORT is not answered.
+/// All fields are big endian (network byte order)
+
+#include <stdint.h>
+
+#include <osiSock.h>
+
+#define MAX_BLOCK_SIZE 256   ///< most words the DAE will send or accept in one datagram
+#define DAE_READ_PORT 10000
+#define DAE_WRITE_PORT 10002
+
+// these structrues need to be packed tightly (gcc also understands this pragma)
+
+#pragma pack(push,2)
+
+struct read_send
+{
+	int32_t start_addr;
+	int16_t block_size; // up to MAX_BLOCK_SIZE
+	read_send(int32_t a, int16_t b) : start_addr(htonl(a)), block_size(htons(b)) { }
+};
+
+struct read_recv
+{
+	int32_t start_addr;
+	int16_t block_size; // up to MAX_BLOCK_SIZE
+	uint32_t data[MAX_BLOCK_SIZE]; // left in network byte order, only the words received are decoded
+};
+
+struct write_send
+{
+	int32_t start_addr;
+	int16_t block_size; // up to MAX_BLOCK_SIZE
+	uint32_t data[MAX_BLOCK_SIZE];
+	write_send(int32_t a, int16_t b) : start_addr(htonl(a)), block_size(htons(b)) { }
+	int byteSize() { return 4 + 2 + 4 * ntohs(block_size); }
+};
+
+#pragma pack(pop)
+
+#endif /* DAEDATAPROTOCOL_H */
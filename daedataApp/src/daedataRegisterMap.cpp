@@ -0,0 +1,128 @@
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+
+#include <epicsTypes.h>
+
+#include "daedataRegisterMap.h"
+
+/// read a register map file, replacing any fields already loaded
+void DAEDataRegisterMap::load(const std::string& filename)
+{
+    std::ifstream ifs(filename.c_str());
+    if (!ifs.good())
+    {
+        throw std::runtime_error("DAEDataRegisterMap: cannot open " + filename);
+    }
+    parse(ifs, filename);
+}
+
+/// read register map lines, replacing any fields already loaded
+/// \param source file name for error messages
+void DAEDataRegisterMap::parse(std::istream& is, const std::string& source)
+{
+    std::vector<Field> fields;
+    size_t nwords = 0;
+    std::string line;
+    for(int lineno = 1; std::getline(is, line); ++lineno)
+    {
+        std::string::size_type comment = line.find('#');
+        if (comment != std::string::npos)
+        {
+            line.erase(comment);
+        }
+        std::istringstream iss(line);
+        std::string name, word_str;
+        unsigned bit = 0, width = 0;
+        if (!(iss >> name))
+        {
+            continue;
+        }
+        iss >> word_str >> bit >> width;
+        char* endp = NULL;
+        unsigned long word = strtoul(word_str.c_str(), &endp, 0);
+        std::string rest;
+        if (iss.fail() || word_str.empty() || *endp != '\0' || (iss >> rest) || width == 0)
+        {
+            std::ostringstream error_message;
+            error_message << "DAEDataRegisterMap: " << source << ":" << lineno << ": expected \"name word bit width\"";
+            throw std::runtime_error(error_message.str());
+        }
+        Field* field = (!fields.empty() && fields.back().name == name ? &(fields.back()) : NULL);
+        for(size_t i=0; i<fields.size() && field == NULL; ++i)
+        {
+            if (fields[i].name == name)
+            {
+                std::ostringstream error_message;
+                error_message << "DAEDataRegisterMap: " << source << ":" << lineno << ": the parts of " << name << " must be on consecutive lines";
+                throw std::runtime_error(error_message.str());
+            }
+        }
+        if (field == NULL)
+        {
+            fields.push_back(Field());
+            field = &(fields.back());
+            field->name = name;
+            field->width = 0;
+        }
+        if (field->width + width > 32)
+        {
+            std::ostringstream error_message;
+            error_message << "DAEDataRegisterMap: " << source << ":" << lineno << ": " << name << " is wider than 32 bits";
+            throw std::runtime_error(error_message.str());
+        }
+        addPart(*field, word + bit / 32, bit % 32, width);
+        nwords = std::max(nwords, field->parts.back().word + 1);
+    }
+    m_fields.swap(fields);
+    m_nwords = nwords;
+}
+
+/// append width bits from bit of word to a field, split at word boundaries. Also used to describe a
+/// single field without a map, as for a "bits=" drvInfo modifier
+void DAEDataRegisterMap::addPart(Field& field, size_t word, unsigned bit, unsigned width)
+{
+    while(width > 0)
+    {
+        Part part;
+        unsigned n = std::min(width, 32 - bit);
+        part.word = word;
+        part.bit = bit;
+        part.mask = (n == 32 ? 0xffffffff : ((epicsUInt32)1 << n) - 1);
+        part.shift = field.width;
+        field.parts.push_back(part);
+        field.width += n;
+        width -= n;
+        ++word;
+        bit = 0;
+    }
+}
+
+/// \return the value of a field from the host order words of the block
+epicsUInt32 DAEDataRegisterMap::extract(const Field& field, const epicsUInt32* words)
+{
+    epicsUInt32 value = 0;
+    for(size_t i=0; i<field.parts.size(); ++i)
+    {
+        const Part& part = field.parts[i];
+        value |= ((words[part.word] >> part.bit) & part.mask) << part.shift;
+    }
+    return value;
+}
+
+/// set the bits of a field in a block of words for a masked write, the inverse of extract(). Only the bits of
+/// the field value in value_mask are set, in words, and the bits of the block they occupy are set in masks
+void DAEDataRegisterMap::insert(const Field& field, epicsUInt32 value, epicsUInt32 value_mask, epicsUInt32* words, epicsUInt32* masks)
+{
+    for(size_t i=0; i<field.parts.size(); ++i)
+    {
+        const Part& part = field.parts[i];
+        epicsUInt32 bits = ((value_mask >> part.shift) & part.mask) << part.bit;
+        words[part.word] = (words[part.word] & ~bits) | (((value >> part.shift) << part.bit) & bits);
+        masks[part.word] |= bits;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef DAEDATAREGISTERMAP_H
+#define DAEDATAREGISTERMAP_H
+
+#include <string>
+#include <vector>
+#include <istream>
+
+#include <epicsTypes.h>
+
+/// Named bit fields of a block of DAE memory, such as the DSP control words of an FPGA, loaded from a
+/// text file with one line per field:
+///
+///     name  word  bit  width
+///
+/// word is the offset in 32 bit words from the start of the block and bit that of the field's lowest bit
+/// in that word. Bits count on through the following words, so bit 55 width 22 of word 0 is the top 9 bits
+/// of word 1 and the low 13 of word 2, as a uint64_t bitfield would lay it out. A field whose parts are not
+/// adjacent is given as several lines with the same name, lowest part first. '#' starts a comment.
+/// Fields are at most 32 bits and are decoded with a table of per word shifts and masks built at load time
+class DAEDataRegisterMap
+{
+public:
+    /// the bits of a field that lie in one word
+    struct Part
+    {
+        size_t word;
+        unsigned bit;         ///< lowest bit in the word
+        epicsUInt32 mask;     ///< of the part's bits once shifted down by bit
+        unsigned shift;       ///< where the part goes in the field value
+    };
+    struct Field
+    {
+        std::string name;
+        unsigned width;
+        std::vector<Part> parts;
+    };
+    DAEDataRegisterMap() : m_nwords(0) { }
+    void load(const std::string& filename);
+    void parse(std::istream& is, const std::string& source);
+    size_t nwords() const { return m_nwords; }   ///< words of the block the fields cover
+    const std::vector<Field>& fields() const { return m_fields; }
+    static epicsUInt32 extract(const Field& field, const epicsUInt32* words);
+    static void insert(const Field& field, epicsUInt32 value, epicsUInt32 value_mask, epicsUInt32* words, epicsUInt32* masks);
+    static void addPart(Field& field, size_t word, unsigned bit, unsigned width);
+
+private:
+    std::vector<Field> m_fields;
+    size_t m_nwords;
+};
+
+#endif /* DAEDATAREGISTERMAP_H */
@@ -0,0 +1,57 @@
+#include <map>
+#include <algorithm>
+
+#include <epicsTypes.h>
+#include <epicsTime.h>
+
+#include "daedataShadow.h"
+
+/// record the values of nwords consecutive words starting at start_address
+void DAEDataShadow::update(unsigned start_address, const epicsUInt32* data, size_t nwords, const epicsTime& when)
+{
+	std::map<unsigned, Word>::iterator it = m_words.lower_bound(start_address);
+	for(size_t i=0; i<nwords; ++i)
+	{
+		unsigned address = start_address + 4 * (unsigned)i;
+		if (it == m_words.end() || it->first != address)
+		{
+			Word w;
+			it = m_words.insert(it, std::pair<unsigned, Word>(address, w));
+		}
+		it->second.value = data[i];
+		it->second.updated = when;
+		++it;
+	}
+}
+
+/// forget nwords words starting at start_address, e.g. after an unverified write
+void DAEDataShadow::invalidate(unsigned start_address, size_t nwords)
+{
+	m_words.erase(m_words.lower_bound(start_address), m_words.lower_bound(start_address + 4 * (unsigned)nwords));
+}
+
+/// fill data from shadow memory if every word is present and no older than max_age seconds
+/// \return true on a cache hit, false if the caller needs to go to the hardware
+bool DAEDataShadow::get(unsigned start_address, epicsUInt32* data, size_t nwords, double max_age, const epicsTime& now)
+{
+	double age = 0.0;
+	std::map<unsigned, Word>::const_iterator it = m_words.find(start_address);
+	for(size_t i=0; i<nwords; ++i, ++it)
+	{
+		if (it == m_words.end() || it->first != start_address + 4 * (unsigned)i)
+		{
+			++m_misses;
+			return false;
+		}
+		age = std::max(age, now - it->second.updated);
+		if (age > max_age)
+		{
+			++m_misses;
+			return false;
+		}
+		data[i] = it->second.value;
+	}
+	++m_hits;
+	m_hit_age += age;
+	return true;
+}
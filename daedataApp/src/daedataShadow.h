@@ -0,0 +1,35 @@
+#ifndef DAEDATASHADOW_H
+#define DAEDATASHADOW_H
+
+#include <map>
+
+#include <epicsTypes.h>
+#include <epicsTime.h>
+
+/// copy of DAE memory as last read from (or written to) the hardware, indexed by word address.
+/// Not thread safe, the owning driver serialises access with its own lock
+class DAEDataShadow
+{
+public:
+    DAEDataShadow() : m_hits(0), m_misses(0), m_hit_age(0.0) { }
+    void update(unsigned start_address, const epicsUInt32* data, size_t nwords, const epicsTime& when);
+    void invalidate(unsigned start_address, size_t nwords);
+    bool get(unsigned start_address, epicsUInt32* data, size_t nwords, double max_age, const epicsTime& now);
+    size_t size() const { return m_words.size(); }
+    epicsUInt32 hits() const { return m_hits; }
+    epicsUInt32 misses() const { return m_misses; }
+    double meanHitAge() const { return (m_hits > 0 ? m_hit_age / m_hits : 0.0); }  ///< seconds
+	
+private:
+    struct Word
+	{
+	    epicsUInt32 value;
+		epicsTime updated;
+	};
+    std::map<unsigned, Word> m_words;  ///< keyed on byte address of the word
+    epicsUInt32 m_hits;
+    epicsUInt32 m_misses;
+    double m_hit_age;   ///< sum over hits of the age of the oldest word returned
+};
+
+#endif /* DAEDATASHADOW_H */
@@ -0,0 +1,234 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <stdint.h>
+
+#include <osiSock.h>
+#include <epicsTime.h>
+
+#include "daedataSim.h"
+
+DAEDataSim::DAEDataSim(const SimOptions& options) : m_options(options), m_random(options.seed),
+    m_sock_read(INVALID_SOCKET), m_sock_write(INVALID_SOCKET), m_read_port(options.read_port), m_write_port(options.write_port), m_start(epicsTime::getCurrent()), m_stopping(false)
+{
+    m_sock_read = openSocket(m_read_port);
+    try
+    {
+        m_sock_write = openSocket(m_write_port);
+    }
+    catch(...)
+    {
+        epicsSocketDestroy(m_sock_read);
+        throw;
+    }
+}
+
+DAEDataSim::~DAEDataSim()
+{
+    if (m_sock_read != INVALID_SOCKET)
+    {
+        epicsSocketDestroy(m_sock_read);
+    }
+    if (m_sock_write != INVALID_SOCKET)
+    {
+        epicsSocketDestroy(m_sock_write);
+    }
+}
+
+/// \param[in,out] port to bind, 0 for any free port, set to the port bound
+SOCKET DAEDataSim::openSocket(unsigned short& port)
+{
+    char error_text[256];
+    std::ostringstream error_message;
+    struct sockaddr_in sa;
+    if (aToIPAddr(m_options.address, port, &sa) < 0)
+    {
+        error_message << "DAEDataSim: bad address " << m_options.address;
+        throw std::runtime_error(error_message.str());
+    }
+    SOCKET sock = epicsSocketCreate(PF_INET, SOCK_DGRAM, 0);
+    if (sock == INVALID_SOCKET)
+    {
+        epicsSocketConvertErrnoToString(error_text, sizeof(error_text));
+        error_message << "DAEDataSim: cannot create socket: " << error_text;
+        throw std::runtime_error(error_message.str());
+    }
+    // room for a whole window of requests from several clients arriving at once
+    int bufsize = 1024 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char*)&bufsize, sizeof(bufsize));
+    if (bind(sock, (struct sockaddr*)&sa, sizeof(sa)) < 0)
+    {
+        epicsSocketConvertErrnoToString(error_text, sizeof(error_text));
+        epicsSocketDestroy(sock);
+        error_message << "DAEDataSim: cannot bind " << m_options.address << ":" << port << ": " << error_text;
+        throw std::runtime_error(error_message.str());
+    }
+    osiSocklen_t salen = sizeof(sa);
+    if (getsockname(sock, (struct sockaddr*)&sa, &salen) < 0)
+    {
+        epicsSocketConvertErrnoToString(error_text, sizeof(error_text));
+        epicsSocketDestroy(sock);
+        error_message << "DAEDataSim: cannot get the port bound: " << error_text;
+        throw std::runtime_error(error_message.str());
+    }
+    port = ntohs(sa.sin_port);
+    return sock;
+}
+
+/// \return host order word at a byte address, a word never written reads back as its own address
+uint32_t DAEDataSim::readWord(uint32_t address) const
+{
+    std::map<uint32_t, uint32_t>::const_iterator it = m_memory.find(address);
+    return (it != m_memory.end() ? it->second : address);
+}
+
+/// answer a read_send, after the configured delay unless it is lost
+void DAEDataSim::handleRead()
+{
+    read_send rs(0, 0);
+    SimReply reply;
+    osiSocklen_t fromlen = sizeof(reply.to);
+    int size = recvfrom(m_sock_read, (char*)&rs, sizeof(rs), 0, (struct sockaddr*)&(reply.to), &fromlen);
+    if (size < 0)
+    {
+        return;
+    }
+    uint32_t start_address = ntohl(rs.start_addr);
+    int block_size = ntohs(rs.block_size);
+    if (size != (int)sizeof(rs) || block_size <= 0 || block_size > MAX_BLOCK_SIZE)
+    {
+        ++m_stats.malformed;
+        return;
+    }
+    ++m_stats.reads;
+    m_stats.read_words += block_size;
+    if (m_random.chance(m_options.loss))
+    {
+        ++m_stats.dropped;
+        return;
+    }
+    // the reply holds memory as it is when the request arrives, however long it is delayed
+    reply.rr.start_addr = rs.start_addr;
+    reply.rr.block_size = rs.block_size;
+    for(int i=0; i<block_size; ++i)
+    {
+        reply.rr.data[i] = htonl(readWord(start_address + 4 * i));
+    }
+    reply.size = 6 + 4 * block_size;
+    double now = elapsed();
+    double delay = m_options.latency + m_options.jitter * m_random.uniform();
+    if (m_random.chance(m_options.reorder))
+    {
+        // held back behind everything sent within the next latency + jitter
+        delay += m_options.latency + m_options.jitter + 0.001;
+        ++m_stats.reordered;
+    }
+    m_replies.insert(std::pair<double, SimReply>(now + delay, reply));
+    if (m_random.chance(m_options.duplicate))
+    {
+        m_replies.insert(std::pair<double, SimReply>(now + delay + m_options.jitter * m_random.uniform(), reply));
+        ++m_stats.duplicated;
+    }
+}
+
+/// apply a write_send to the register file, unless it is lost
+void DAEDataSim::handleWrite()
+{
+    write_send ws(0, 0);
+    int size = recv(m_sock_write, (char*)&ws, sizeof(ws), 0);
+    if (size < 0)
+    {
+        return;
+    }
+    uint32_t start_address = ntohl(ws.start_addr);
+    int block_size = ntohs(ws.block_size);
+    if (size < 6 || block_size <= 0 || block_size > MAX_BLOCK_SIZE || size != 6 + 4 * block_size)
+    {
+        ++m_stats.malformed;
+        return;
+    }
+    ++m_stats.writes;
+    m_stats.write_words += block_size;
+    if (m_random.chance(m_options.write_loss))
+    {
+        ++m_stats.dropped_writes;
+        return;
+    }
+    for(int i=0; i<block_size; ++i)
+    {
+        m_memory[start_address + 4 * i] = ntohl(ws.data[i]);
+    }
+}
+
+/// send every reply whose delay has passed
+void DAEDataSim::sendDue(double now)
+{
+    while(!m_replies.empty() && m_replies.begin()->first <= now)
+    {
+        const SimReply& reply = m_replies.begin()->second;
+        if (sendto(m_sock_read, (const char*)&(reply.rr), reply.size, 0, (const struct sockaddr*)&(reply.to), sizeof(reply.to)) == reply.size)
+        {
+            ++m_stats.replies;
+        }
+        m_replies.erase(m_replies.begin());
+    }
+}
+
+void DAEDataSim::printStats(double now) const
+{
+    printf("daedataSim: %.1f s: %lu reads (%lu words) %lu replies, %lu lost, %lu reordered, %lu duplicated; "
+           "%lu writes (%lu words) %lu lost; %lu malformed\n", now, m_stats.reads, m_stats.read_words, m_stats.replies,
+           m_stats.dropped, m_stats.reordered, m_stats.duplicated, m_stats.writes, m_stats.write_words, m_stats.dropped_writes, m_stats.malformed);
+    fflush(stdout);
+}
+
+/// serve requests until the run time is up or stop() is called
+void DAEDataSim::run()
+{
+    double next_stats = m_options.interval;
+    while(!m_stopping)
+    {
+        double now = elapsed();
+        sendDue(now);
+        if (m_options.run_time > 0.0 && now >= m_options.run_time)
+        {
+            printStats(now);
+            return;
+        }
+        if (m_options.interval > 0.0 && now >= next_stats)
+        {
+            printStats(now);
+            next_stats += m_options.interval;
+        }
+        double wait = 0.1;
+        if (!m_replies.empty())
+        {
+            wait = std::min(wait, m_replies.begin()->first - now);
+        }
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(m_sock_read, &fds);
+        FD_SET(m_sock_write, &fds);
+        struct timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = (wait > 0.0 ? (long)(wait * 1e6) : 0);
+        int n = select((int)std::max(m_sock_read, m_sock_write) + 1, &fds, NULL, NULL, &tv);
+        if (n <= 0)
+        {
+            continue;
+        }
+        // apply writes first, so a read sent after a write always sees it
+        if (FD_ISSET(m_sock_write, &fds))
+        {
+            handleWrite();
+        }
+        if (FD_ISSET(m_sock_read, &fds))
+        {
+            handleRead();
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef DAEDATASIM_H
+#define DAEDATASIM_H
+
+#include <map>
+#include <stdint.h>
+
+#include <osiSock.h>
+#include <epicsTime.h>
+
+#include "daedataProtocol.h"
+
+/// xorshift64*, our own rather than rand() so a seed gives the same choices on every platform
+class SimRandom
+{
+public:
+    explicit SimRandom(uint64_t seed) : m_state(seed != 0 ? seed : 0x9e3779b97f4a7c15ULL) { }
+    uint64_t next()
+    {
+        m_state ^= m_state >> 12;
+        m_state ^= m_state << 25;
+        m_state ^= m_state >> 27;
+        return m_state * 2685821657736338717ULL;
+    }
+    /// \return uniform in [0,1)
+    double uniform() { return (double)(next() >> 11) / 9007199254740992.0; }
+    bool chance(double p) { return p > 0.0 && uniform() < p; }
+private:
+    uint64_t m_state;
+};
+
+struct SimOptions
+{
+    const char* address;
+    unsigned short read_port;   ///< 0 for any free port, see DAEDataSim::readPort()
+    unsigned short write_port;  ///< 0 for any free port, see DAEDataSim::writePort()
+    double latency;     ///< seconds
+    double jitter;      ///< seconds
+    double loss;
+    double write_loss;
+    double reorder;
+    double duplicate;
+    unsigned long seed;
+    double interval;    ///< seconds between statistics, 0 for none
+    double run_time;    ///< seconds, 0 for ever
+    SimOptions() : address("127.0.0.1"), read_port(DAE_READ_PORT), write_port(DAE_WRITE_PORT), latency(0.0), jitter(0.0), loss(0.0), write_loss(0.0), reorder(0.0), duplicate(0.0),
+                   seed(1), interval(0.0), run_time(0.0) { }
+};
+
+struct SimStats
+{
+    unsigned long reads;
+    unsigned long read_words;
+    unsigned long writes;
+    unsigned long write_words;
+    unsigned long replies;
+    unsigned long dropped;
+    unsigned long dropped_writes;
+    unsigned long reordered;
+    unsigned long duplicated;
+    unsigned long malformed;
+    SimStats() : reads(0), read_words(0), writes(0), write_words(0), replies(0), dropped(0), dropped_writes(0),
+                 reordered(0), duplicated(0), malformed(0) { }
+};
+
+/// a read reply waiting for its delay to pass
+struct SimReply
+{
+    read_recv rr;
+    int size;
+    struct sockaddr_in to;
+};
+
+/// Simulator of the DAE memory access protocol (see daedataProtocol.h) for loopback testing and load
+/// benchmarks without hardware. Reads are answered from an in-memory register file in which words never
+/// written read back as their own address, as DAEDataUDP's simulate mode does. Read replies can be
+/// delayed, dropped, reordered and duplicated, and writes dropped. Every random choice comes from a
+/// seeded generator, so a run with the same options and the same sequence of requests makes the same choices.
+/// Used by the daedataSim program, and run in process by daedataUDPBench
+class DAEDataSim
+{
+public:
+    DAEDataSim(const SimOptions& options);
+    ~DAEDataSim();
+    void run();
+    void stop() { m_stopping = true; }
+    const SimStats& stats() const { return m_stats; }
+    unsigned short readPort() const { return m_read_port; }     ///< as bound, the one chosen if SimOptions::read_port was 0
+    unsigned short writePort() const { return m_write_port; }
+    void printStats() const { printStats(elapsed()); }
+
+private:
+    SimOptions m_options;
+    SimRandom m_random;
+    SimStats m_stats;
+    SOCKET m_sock_read;
+    SOCKET m_sock_write;
+    unsigned short m_read_port;
+    unsigned short m_write_port;
+    epicsTime m_start;
+    volatile bool m_stopping;
+    std::map<uint32_t, uint32_t> m_memory;        ///< byte address -> host order word, for words that have been written
+    std::multimap<double, SimReply> m_replies;     ///< keyed on seconds since m_start when due to be sent
+    SOCKET openSocket(unsigned short& port);
+    double elapsed() const { return epicsTime::getCurrent() - m_start; }
+    uint32_t readWord(uint32_t address) const;
+    void handleRead();
+    void handleWrite();
+    void sendDue(double now);
+    void printStats(double now) const;
+};
+
+#endif /* DAEDATASIM_H */
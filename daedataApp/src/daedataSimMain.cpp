@@ -0,0 +1,123 @@
+/// Simulated DAE for loopback testing without hardware, see DAEDataSim
+///
+/// usage: daedataSim [-a address] [-R read_port] [-W write_port] [-l latency_ms] [-j jitter_ms] [-p loss] [-w write_loss]
+///                   [-r reorder] [-d duplicate] [-s seed] [-i stats_interval_s] [-t run_time_s]
+///
+/// -a  address to listen on, default 127.0.0.1
+/// -R  port to take reads on, default 10000 as the DAE, 0 for any free port
+/// -W  port to take writes on, default 10002 as the DAE, 0 for any free port
+/// -l  fixed delay before each read reply, milliseconds
+/// -j  extra uniformly distributed delay of up to this many milliseconds per reply
+/// -p  probability a read request goes unanswered
+/// -w  probability a write is ignored
+/// -r  probability a reply is held back until after the replies to later requests
+/// -d  probability a reply is sent twice
+/// -s  random number seed
+/// -i  print statistics every this many seconds
+/// -t  exit after this many seconds, printing statistics (default run until killed)
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <osiSock.h>
+#include <epicsGetopt.h>
+
+#include "daedataSim.h"
+
+static void usage()
+{
+    fprintf(stderr, "usage: daedataSim [-a address] [-R read_port] [-W write_port] [-l latency_ms] [-j jitter_ms] [-p loss] [-w write_loss]\n"
+                    "                  [-r reorder] [-d duplicate] [-s seed] [-i stats_interval_s] [-t run_time_s]\n"
+                    "\n"
+                    "  -a  address to listen on, default 127.0.0.1\n"
+                    "  -R  port to take reads on, default 10000 as the DAE, 0 for any free port\n"
+                    "  -W  port to take writes on, default 10002 as the DAE, 0 for any free port\n"
+                    "  -l  fixed delay before each read reply, milliseconds\n"
+                    "  -j  extra uniformly distributed delay of up to this many milliseconds per reply\n"
+                    "  -p  probability (0 to 1) a read request goes unanswered\n"
+                    "  -w  probability a write is ignored\n"
+                    "  -r  probability a reply is held back until after the replies to later requests\n"
+                    "  -d  probability a reply is sent twice\n"
+                    "  -s  random number seed\n"
+                    "  -i  print statistics every this many seconds\n"
+                    "  -t  exit after this many seconds, printing statistics (default run until killed)\n");
+    exit(1);
+}
+
+int main(int argc, char* argv[])
+{
+    SimOptions options;
+    int c;
+    while((c = getopt(argc, argv, "a:R:W:l:j:p:w:r:d:s:i:t:h")) != -1)
+    {
+        switch(c)
+        {
+        case 'a':
+            options.address = optarg;
+            break;
+        case 'R':
+            options.read_port = (unsigned short)strtoul(optarg, NULL, 0);
+            break;
+        case 'W':
+            options.write_port = (unsigned short)strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            options.latency = atof(optarg) / 1000.0;
+            break;
+        case 'j':
+            options.jitter = atof(optarg) / 1000.0;
+            break;
+        case 'p':
+            options.loss = atof(optarg);
+            break;
+        case 'w':
+            options.write_loss = atof(optarg);
+            break;
+        case 'r':
+            options.reorder = atof(optarg);
+            break;
+        case 'd':
+            options.duplicate = atof(optarg);
+            break;
+        case 's':
+            options.seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'i':
+            options.interval = atof(optarg);
+            break;
+        case 't':
+            options.run_time = atof(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+    if (optind != argc)
+    {
+        usage();
+    }
+    if (!osiSockAttach())
+    {
+        fprintf(stderr, "daedataSim: cannot initialise sockets\n");
+        return 1;
+    }
+    try
+    {
+        DAEDataSim sim(options);
+        printf("daedataSim: listening on %s ports %d (read) and %d (write), latency %.1f ms jitter %.1f ms, loss %g, write loss %g, reorder %g, duplicate %g, seed %lu\n",
+               options.address, sim.readPort(), sim.writePort(), 1000.0 * options.latency, 1000.0 * options.jitter, options.loss, options.write_loss,
+               options.reorder, options.duplicate, options.seed);
+        fflush(stdout);
+        sim.run();
+    }
+    catch(const std::exception& ex)
+    {
+        fprintf(stderr, "daedataSim: %s\n", ex.what());
+        osiSockRelease();
+        return 1;
+    }
+    osiSockRelease();
+    return 0;
+}
+
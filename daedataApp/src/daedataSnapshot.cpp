@@ -0,0 +1,283 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+
+#include <osiSock.h>
+#include <epicsTypes.h>
+
+#include "asynDriver.h"
+
+#include "daedataSnapshot.h"
+
+static const epicsUInt32 SNAPSHOT_MAGIC = 0x44414553;  ///< "DAES"
+static const epicsUInt32 SNAPSHOT_VERSION = 1;
+static const size_t SNAPSHOT_HOST_WORDS = 16;   ///< host name field of the header, NUL padded
+static const size_t SNAPSHOT_MAX_WORDS = 64 * 1024 * 1024;   ///< sanity limit on a range read from a file
+
+/// \return the number of datagrams a write of nwords words takes
+static size_t datagrams(size_t nwords)
+{
+    return (nwords + MAX_BLOCK_SIZE - 1) / MAX_BLOCK_SIZE;
+}
+
+DAEDataSnapshot::DAEDataSnapshot() : m_taken(0)
+{
+    std::fill(m_firmware, m_firmware + FIRMWARE_WORDS, 0);
+}
+
+/// add a range of memory to be captured, merged with any range it overlaps or adjoins
+void DAEDataSnapshot::addRange(unsigned start, size_t nwords)
+{
+    Range range;
+    range.start = start;
+    range.words.resize(nwords);
+    m_ranges.push_back(range);
+    std::vector<Range> ranges;
+    std::vector< std::pair<unsigned, size_t> > sorted;
+    for(size_t i=0; i<m_ranges.size(); ++i)
+    {
+        sorted.push_back(std::pair<unsigned, size_t>(m_ranges[i].start, m_ranges[i].words.size()));
+    }
+    std::sort(sorted.begin(), sorted.end());
+    for(size_t i=0; i<sorted.size(); ++i)
+    {
+        unsigned end = sorted[i].first + 4 * (unsigned)sorted[i].second;
+        if (!ranges.empty() && sorted[i].first <= ranges.back().start + 4 * (unsigned)ranges.back().words.size())
+        {
+            Range& last = ranges.back();
+            last.words.resize(std::max(last.words.size(), (size_t)((end - last.start) / 4)));
+            continue;
+        }
+        ranges.push_back(Range());
+        ranges.back().start = sorted[i].first;
+        ranges.back().words.resize(sorted[i].second);
+    }
+    m_ranges.swap(ranges);
+}
+
+/// \return the number of words in all the ranges
+size_t DAEDataSnapshot::nwords() const
+{
+    size_t n = 0;
+    for(size_t i=0; i<m_ranges.size(); ++i)
+    {
+        n += m_ranges[i].words.size();
+    }
+    return n;
+}
+
+/// read the ranges, one after another into live, and the firmware words as one batch of block reads
+void DAEDataSnapshot::readLive(DAEDataUDP* udp, asynUser* pasynUser, std::vector<epicsUInt32>& live, epicsUInt32* firmware) const
+{
+    std::vector<DAEDataUDP::Block> blocks(m_ranges.size() + 1);
+    live.resize(nwords());
+    for(size_t i=0, offset=0; i<m_ranges.size(); offset += m_ranges[i].words.size(), ++i)
+    {
+        DAEDataUDP::Block block = { m_ranges[i].start, &(live[offset]), m_ranges[i].words.size(), DAEDataUDP::Words32, 0 };
+        blocks[i] = block;
+    }
+    DAEDataUDP::Block block = { FIRMWARE_ADDRESS, firmware, FIRMWARE_WORDS, DAEDataUDP::Words32, 0 };
+    blocks.back() = block;
+    udp->readBlocks(&(blocks[0]), blocks.size(), pasynUser);
+}
+
+/// read the ranges added with addRange() and the firmware words from the hardware
+void DAEDataSnapshot::capture(DAEDataUDP* udp, asynUser* pasynUser, const std::string& host)
+{
+    std::vector<epicsUInt32> live;
+    readLive(udp, pasynUser, live, m_firmware);
+    for(size_t i=0, offset=0; i<m_ranges.size(); offset += m_ranges[i].words.size(), ++i)
+    {
+        std::copy(live.begin() + offset, live.begin() + offset + m_ranges[i].words.size(), m_ranges[i].words.begin());
+    }
+    m_host = host;
+    m_taken = time(NULL);
+}
+
+/// write the snapshot to a file, replacing it. The words go to a temporary file that is then renamed, so
+/// a failed or interrupted save leaves any earlier snapshot of the same name intact
+void DAEDataSnapshot::save(const std::string& filename) const
+{
+    std::vector<epicsUInt32> words;
+    words.push_back(SNAPSHOT_MAGIC);
+    words.push_back(SNAPSHOT_VERSION);
+    char host[4 * SNAPSHOT_HOST_WORDS];
+    memset(host, 0, sizeof(host));
+    strncpy(host, m_host.c_str(), sizeof(host) - 1);
+    for(size_t i=0; i<SNAPSHOT_HOST_WORDS; ++i)
+    {
+        epicsUInt32 w;
+        memcpy(&w, host + 4 * i, 4);
+        words.push_back(ntohl(w));   // so the bytes go out in order
+    }
+    words.push_back((epicsUInt32)m_taken);   // unsigned 32 bit seconds, good until 2106
+    words.insert(words.end(), m_firmware, m_firmware + FIRMWARE_WORDS);
+    words.push_back((epicsUInt32)m_ranges.size());
+    for(size_t i=0; i<m_ranges.size(); ++i)
+    {
+        words.push_back(m_ranges[i].start);
+        words.push_back((epicsUInt32)m_ranges[i].words.size());
+        words.insert(words.end(), m_ranges[i].words.begin(), m_ranges[i].words.end());
+    }
+    for(size_t i=0; i<words.size(); ++i)
+    {
+        words[i] = htonl(words[i]);
+    }
+    std::string tmp_filename = filename + ".tmp";
+    {
+        std::ofstream ofs(tmp_filename.c_str(), std::ios::binary | std::ios::trunc);
+        if (!ofs.write((const char*)&(words[0]), 4 * words.size()) || !ofs.flush())
+        {
+            ofs.close();
+            remove(tmp_filename.c_str());
+            throw std::runtime_error("DAEDataSnapshot: cannot write " + tmp_filename);
+        }
+    }
+#ifdef _WIN32
+    remove(filename.c_str());   // rename() does not replace an existing file on Windows
+#endif
+    if (rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+        remove(tmp_filename.c_str());
+        throw std::runtime_error("DAEDataSnapshot: cannot rename " + tmp_filename + " to " + filename);
+    }
+}
+
+/// read words from a snapshot file
+static void readWords(std::istream& is, epicsUInt32* words, size_t n, const std::string& filename)
+{
+    if (n > 0 && !is.read((char*)words, 4 * n))
+    {
+        throw std::runtime_error("DAEDataSnapshot: " + filename + " is truncated");
+    }
+    for(size_t i=0; i<n; ++i)
+    {
+        words[i] = ntohl(words[i]);
+    }
+}
+
+/// read a snapshot written by save(), replacing the ranges
+void DAEDataSnapshot::load(const std::string& filename)
+{
+    std::ifstream ifs(filename.c_str(), std::ios::binary);
+    if (!ifs.good())
+    {
+        throw std::runtime_error("DAEDataSnapshot: cannot open " + filename);
+    }
+    epicsUInt32 header[2 + SNAPSHOT_HOST_WORDS + 1 + FIRMWARE_WORDS + 1];
+    readWords(ifs, header, sizeof(header) / sizeof(epicsUInt32), filename);
+    if (header[0] != SNAPSHOT_MAGIC || header[1] != SNAPSHOT_VERSION)
+    {
+        std::ostringstream error_message;
+        error_message << "DAEDataSnapshot: " << filename << " is not a version " << SNAPSHOT_VERSION << " snapshot";
+        throw std::runtime_error(error_message.str());
+    }
+    char host[4 * SNAPSHOT_HOST_WORDS + 1];
+    for(size_t i=0; i<SNAPSHOT_HOST_WORDS; ++i)
+    {
+        epicsUInt32 w = htonl(header[2 + i]);
+        memcpy(host + 4 * i, &w, 4);
+    }
+    host[sizeof(host) - 1] = '\0';
+    const epicsUInt32* p = header + 2 + SNAPSHOT_HOST_WORDS;
+    time_t taken = (time_t)*p++;
+    epicsUInt32 firmware[FIRMWARE_WORDS];
+    std::copy(p, p + FIRMWARE_WORDS, firmware);
+    p += FIRMWARE_WORDS;
+    epicsUInt32 nranges = *p;
+    std::vector<Range> ranges;
+    for(epicsUInt32 i=0; i<nranges; ++i)
+    {
+        epicsUInt32 range[2];
+        readWords(ifs, range, 2, filename);
+        if (range[0] % 4 != 0 || range[1] == 0 || range[1] > SNAPSHOT_MAX_WORDS ||
+            (!ranges.empty() && range[0] < ranges.back().start + 4 * (unsigned)ranges.back().words.size()))
+        {
+            std::ostringstream error_message;
+            error_message << "DAEDataSnapshot: " << filename << ": invalid range " << i << " at address 0x" << std::hex << range[0];
+            throw std::runtime_error(error_message.str());
+        }
+        ranges.push_back(Range());
+        ranges.back().start = range[0];
+        ranges.back().words.resize(range[1]);
+        readWords(ifs, &(ranges.back().words[0]), range[1], filename);
+    }
+    m_host = host;
+    m_taken = taken;
+    std::copy(firmware, firmware + FIRMWARE_WORDS, m_firmware);
+    m_ranges.swap(ranges);
+}
+
+/// compare the snapshot with the hardware, reading all its ranges as one batch of block reads
+/// \param[out] differences each word whose hardware value (actual) is not that in the snapshot (expected), in address order
+/// \param[out] firmware FIRMWARE_WORDS words, the hardware's firmware words
+void DAEDataSnapshot::diff(DAEDataUDP* udp, asynUser* pasynUser, std::vector<DAEDataUDP::Mismatch>& differences, epicsUInt32* firmware) const
+{
+    std::vector<epicsUInt32> live;
+    readLive(udp, pasynUser, live, firmware);
+    differences.clear();
+    for(size_t i=0, offset=0; i<m_ranges.size(); offset += m_ranges[i].words.size(), ++i)
+    {
+        const std::vector<epicsUInt32>& words = m_ranges[i].words;
+        for(size_t j=0; j<words.size(); ++j)
+        {
+            if (words[j] != live[offset + j])
+            {
+                DAEDataUDP::Mismatch m = { m_ranges[i].start + 4 * (unsigned)j, words[j], live[offset + j] };
+                differences.push_back(m);
+            }
+        }
+    }
+}
+
+/// stage the snapshot words found to differ by diff() for writing back. Runs of them a few words apart in the same
+/// range are joined, writing back the matching words between as well, wherever that takes fewer datagrams
+/// \return the number of words staged
+size_t DAEDataSnapshot::stageRestore(const std::vector<DAEDataUDP::Mismatch>& differences, DAEDataConfig& config) const
+{
+    // runs of consecutive differing words, as (range, first word, end word) indexes
+    std::vector<size_t> run_range, run_first, run_end;
+    size_t r = 0;
+    for(size_t i=0; i<differences.size(); ++i)
+    {
+        unsigned address = differences[i].address;
+        while(r < m_ranges.size() && address >= m_ranges[r].start + 4 * (unsigned)m_ranges[r].words.size())
+        {
+            ++r;
+        }
+        if (r == m_ranges.size() || address < m_ranges[r].start)
+        {
+            throw std::runtime_error("DAEDataSnapshot: difference outside the snapshot's ranges");
+        }
+        size_t index = (address - m_ranges[r].start) / 4;
+        if (!run_range.empty() && run_range.back() == r && run_end.back() == index)
+        {
+            ++run_end.back();
+            continue;
+        }
+        if (!run_range.empty() && run_range.back() == r &&
+            datagrams(index + 1 - run_first.back()) < datagrams(run_end.back() - run_first.back()) + 1)
+        {
+            // bridging the gap saves the datagram a new run would start
+            run_end.back() = index + 1;
+            continue;
+        }
+        run_range.push_back(r);
+        run_first.push_back(index);
+        run_end.push_back(index + 1);
+    }
+    size_t nstaged = 0;
+    for(size_t i=0; i<run_range.size(); ++i)
+    {
+        const Range& range = m_ranges[run_range[i]];
+        config.stage(range.start + 4 * (unsigned)run_first[i], &(range.words[run_first[i]]), run_end[i] - run_first[i]);
+        nstaged += run_end[i] - run_first[i];
+    }
+    return nstaged;
+}
@@ -0,0 +1,48 @@
+#ifndef DAEDATASNAPSHOT_H
+#define DAEDATASNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <ctime>
+
+#include <epicsTypes.h>
+
+#include "daedataUDP.h"
+#include "daedataConfig.h"
+
+/// A copy of ranges of a board's memory, such as its configuration registers, read in one batch of block
+/// reads and kept in a compact binary file, to compare with the hardware later or to restore it after e.g.
+/// a power cycle. The file is a header (the DAE host, when the snapshot was taken and the firmware words
+/// at FIRMWARE_ADDRESS) followed by each range's start address, length in words and words, all as big endian
+/// 32 bit words, the time as unsigned seconds since 1970 so until 2106. Not thread safe, the owner serialises access
+class DAEDataSnapshot
+{
+public:
+    enum { FIRMWARE_ADDRESS = 0x1000, FIRMWARE_WORDS = 4 };
+    struct Range
+    {
+        unsigned start;
+        std::vector<epicsUInt32> words;
+    };
+    DAEDataSnapshot();
+    void addRange(unsigned start, size_t nwords);
+    void capture(DAEDataUDP* udp, asynUser* pasynUser, const std::string& host);
+    void save(const std::string& filename) const;
+    void load(const std::string& filename);
+    void diff(DAEDataUDP* udp, asynUser* pasynUser, std::vector<DAEDataUDP::Mismatch>& differences, epicsUInt32* firmware) const;
+    size_t stageRestore(const std::vector<DAEDataUDP::Mismatch>& differences, DAEDataConfig& config) const;
+    const std::string& host() const { return m_host; }
+    time_t taken() const { return m_taken; }
+    const epicsUInt32* firmware() const { return m_firmware; }
+    const std::vector<Range>& ranges() const { return m_ranges; }
+    size_t nwords() const;
+
+private:
+    std::string m_host;
+    time_t m_taken;
+    epicsUInt32 m_firmware[FIRMWARE_WORDS];
+    std::vector<Range> m_ranges;   ///< in address order, not overlapping
+    void readLive(DAEDataUDP* udp, asynUser* pasynUser, std::vector<epicsUInt32>& live, epicsUInt32* firmware) const;
+};
+
+#endif /* DAEDATASNAPSHOT_H */
@@ -4,6 +4,7 @@
 #include <string>
 #include <list>
 #include <map>
+#include <algorithm>
 #include <stdexcept>
 
 #include <cstdio>
@@ -11,6 +12,7 @@
 #include <ctime>
 #include <cstdarg>
 #include <cstddef>
+#include <cstring>
 #include <cctype>
 #include <stdint.h>
 
@@ -18,6 +20,11 @@
 #include <osiSock.h>
 #include <epicsMutex.h>
 #include <epicsGuard.h>
+#include <epicsEndian.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsAtomic.h>
+#include <errlog.h>
 
 #ifdef _WIN32
 #include <winsock2.h> // needs to be before windows.h
@@ -29,6 +36,9 @@
 #include <direct.h>
 #include <io.h>
 #endif /* _WIN32 */
+#ifndef _WIN32
+#include <poll.h>
+#endif /* _WIN32 */
 #include <sys/stat.h>
 #include <sys/timeb.h>
 #include <fcntl.h>
@@ -38,90 +48,109 @@
 //#include <psapi.h>
 
 #include "daedataUDP.h"
+#include "daedataProtocol.h"
+#include "daedataKernels.h"
+#include "daedataError.h"
 
-#define MAX_BLOCK_SIZE 256
-
-// these structrues need to be packed tightly
-
-#ifdef _MSC_VER
-#pragma pack(push,2)
-#endif /* _MSC_VER */
+/// the conversion kernel layout for a format
+static DAEDataLayout formatLayout(DAEDataUDP::Format format)
+{
+	switch(format)
+	{
+	case DAEDataUDP::Halves16Native:
+#if EPICS_BYTE_ORDER == EPICS_ENDIAN_BIG
+		return DAEDataLayoutHalvesHigh;
+#else
+		return DAEDataLayoutHalvesLow;
+#endif
+	case DAEDataUDP::Halves16HighFirst:
+		return DAEDataLayoutHalvesHigh;
+	case DAEDataUDP::Halves16LowFirst:
+		return DAEDataLayoutHalvesLow;
+	case DAEDataUDP::Low16:
+		return DAEDataLayoutLow16;
+	default:
+		return DAEDataLayout32;
+	}
+}
 
-struct read_send
+/// decode network order words straight into a caller's buffer laid out as format
+static void decodeWords(const uint32_t* wire, size_t n, DAEDataUDP::Format format, uint32_t offset, void* data)
 {
-	int32_t start_addr;
-	int16_t block_size; // up to MAX_BLOCK_SIZE
-	read_send(int32_t a, int16_t b) : start_addr(htonl(a)), block_size(htons(b)) { }
-};
+	daedataKernels().decode[formatLayout(format)](wire, data, n, offset);
+}
 
-struct read_recv
+/// encode words from a caller's buffer laid out as format into network order
+static void encodeWords(const void* data, DAEDataUDP::Format format, uint32_t offset, size_t n, uint32_t* wire)
 {
-	int32_t start_addr;
-	int16_t block_size; // up to MAX_BLOCK_SIZE
-	uint32_t data[MAX_BLOCK_SIZE];
-	void flip_endian()
-	{
-		start_addr = ntohl(start_addr);
-		block_size = ntohs(block_size);
-		for(int i=0; i<MAX_BLOCK_SIZE; ++i)
-		{
-			data[i] = ntohl(data[i]);
-		}
-	}
-};
+	daedataKernels().encode[formatLayout(format)](data, wire, n, offset);
+}
 
-struct write_send
+/// host order word i of a caller's buffer laid out as format
+static uint32_t getWord(const void* data, DAEDataUDP::Format format, uint32_t offset, size_t i)
 {
-	int32_t start_addr;
-	int16_t block_size; // up to MAX_BLOCK_SIZE
-	uint32_t data[MAX_BLOCK_SIZE];
-	write_send(int32_t a, int16_t b, const uint32_t* d) : start_addr(htonl(a)), block_size(htons(b)) { for(int i=0; i<b; ++i) { data[i] = htonl(d[i]); } }
-	int byteSize() { return 4 + 2 + 4 * ntohs(block_size); } 
-};
-
-#ifdef _MSC_VER
-#pragma pack(pop)
-#endif /* _MSC_VER */
-
-// end of packing
-static const char* socket_errmsg()
+	uint32_t word;
+	encodeWords((const char*)data + i * DAEDataUDP::formatBytes(format), format, offset, 1, &word);
+	return ntohl(word);
+}
+
+/// the last socket error as text, for the constructor's errors (the hot paths use DAEDataError)
+static std::string socket_errmsg()
 {
-	static char error_message[2048];
+	char error_message[256];
 	epicsSocketConvertErrnoToString(error_message, sizeof(error_message));
 	return error_message;
 }
 static const std::string FUNCNAME = "DAEDataUDP";
 
+static const size_t DEFAULT_READ_WINDOW = 8;   ///< default number of read requests in flight
+static const double READ_TIMEOUT = 0.2;        ///< seconds to wait for a reply before retransmitting, the starting point when adaptive
+static const int READ_RETRIES = 6;             ///< retransmissions before giving up on a request
+static const double MIN_RTO = 0.005;           ///< adaptive retransmit timeout bounds, seconds
+static const double MAX_RTO = 1.0;             ///< unless a longer timeout is configured or given by the asynUser
+static const int RECV_BATCH = 16;              ///< most replies taken per recvmmsg() call
+static const int RECV_POLL_MS = 200;            ///< receive thread wakes this often to check for shutdown
+static const int VERIFY_REREADS = 2;           ///< times a write readback that does not match is read again before the verify fails
+static const double MAX_STRAGGLER_WAIT = 0.1;  ///< longest wait in seconds before a reread, as writers queue behind it on m_write_lock
+
+static const int LINK_DOWN_TIMEOUTS = 3;       ///< reads timing out in a row that take the link down
+static const unsigned PROBE_ADDRESS = 0x1000;  ///< the firmware words, read by the probe until the board has answered anything
+static const double PROBE_PERIOD = 1.0;        ///< seconds between probe reads while the link is down
+static const double ERROR_LOG_PERIOD = 1.0;    ///< seconds between errors traced, those in between are only counted
+
+/// upper bounds of the round trip time histogram buckets in seconds, the last bucket takes everything slower
+static const double RTT_LIMITS[DAEDataUDP::RTT_BUCKETS - 1] = { 0.00025, 0.0005, 0.001, 0.002, 0.005, 0.01, 0.02, 0.05 };
+
 	
-  DAEDataUDP::DAEDataUDP(const char* host, bool simulate) : m_host(host), m_simulate(simulate), m_sock_read(INVALID_SOCKET), m_sock_write(INVALID_SOCKET)
+  /// \param timeout seconds before retransmitting a read, where adaptive timeouts start from (0 for default)
+  /// \param retries retransmissions before a read fails (negative for default)
+  /// \param read_port, write_port UDP ports of the DAE, other than DAE_READ_PORT and DAE_WRITE_PORT e.g. for a DAEDataSim on free ports
+  DAEDataUDP::DAEDataUDP(const char* host, bool simulate, int options, size_t window, double timeout, int retries, 
+                         unsigned short read_port, unsigned short write_port) : m_host(host), m_simulate(simulate), 
+	    m_word_reads((options & DAEDataUDPWordReads) != 0), m_sock_write(INVALID_SOCKET),
+		m_requests(NumChannels * (window > 0 ? window : DEFAULT_READ_WINDOW)), m_timeout(READ_TIMEOUT), m_max_rto(MAX_RTO), m_max_retries(READ_RETRIES),
+		m_adaptive((options & DAEDataUDPFixedTimeout) == 0), m_link_down(0), m_timeouts(0), m_probe_address(PROBE_ADDRESS), m_log_suppressed(0), 
+		m_exiting(false), m_receive_thread(false)
 	{
-		if ( (aToIPAddr(host, 10000, &m_sa_read_send) < 0) ||
+		setTimeout(timeout, retries);
+		for(int c=0; c<NumChannels; ++c)
+		{
+			m_channels[c].count = m_requests.size() / NumChannels;
+			m_channels[c].first = c * m_channels[c].count;
+			for(size_t i=0; i<m_channels[c].count; ++i)
+			{
+				m_requests[m_channels[c].first + i].channel = (Channel)c;
+			}
+		}
+		if ( (aToIPAddr(host, read_port, &m_sa_read_send) < 0) ||
 		     (aToIPAddr("0.0.0.0", 0, &m_sa_read_recv) < 0) ||
-		     (aToIPAddr(host, 10002, &m_sa_write_send) < 0) )
+		     (aToIPAddr(host, write_port, &m_sa_write_send) < 0) )
 		{
 			throw std::runtime_error(std::string(FUNCNAME) + ": Bad IP address : " + host);
 		}
-		if (m_sock_read == INVALID_SOCKET)
+		for(int c=0; c<NumChannels; ++c)
 		{
-			m_sock_read = epicsSocketCreate(PF_INET, SOCK_DGRAM, 0);
-			if (m_sock_read == INVALID_SOCKET)
-			{
-				throw std::runtime_error(std::string(FUNCNAME) + ": Can't create recv socket: " + socket_errmsg());
-			}
-			if (bind(m_sock_read, (struct sockaddr *) &m_sa_read_recv, sizeof(m_sa_read_recv)) < 0)
-			{
-				std::string error_msg = socket_errmsg();  // make copy before calling epicsSocketDestroy
-				epicsSocketDestroy(m_sock_read);
-				m_sock_read = INVALID_SOCKET;
-				throw std::runtime_error(std::string(FUNCNAME) + ": bind failed: " + error_msg);
-			}
-			if (connect(m_sock_read, (struct sockaddr *) &m_sa_read_send, sizeof(m_sa_read_send)) < 0)
-			{
-				std::string error_msg = socket_errmsg();  // make copy before calling epicsSocketDestroy
-				epicsSocketDestroy(m_sock_read);
-				m_sock_read = INVALID_SOCKET;
-				throw std::runtime_error(std::string(FUNCNAME) + ": connect failed: " + error_msg);
-			}
+			m_channels[c].sock = openReadSocket();
 		}
 	    m_sock_write = epicsSocketCreate(PF_INET, SOCK_DGRAM, 0);
 		if (m_sock_write == INVALID_SOCKET)
@@ -131,19 +160,36 @@ static const std::string FUNCNAME = "DAEDataUDP";
 		}
 		if (connect(m_sock_write, (struct sockaddr *) &m_sa_write_send, sizeof(m_sa_write_send)) < 0)
 		{
-			std::string error_msg = socket_errmsg();  // make copy before calling epicsSocketDestroy
+			std::string error_msg = socket_errmsg();  // before calling epicsSocketDestroy
 			epicsSocketDestroy(m_sock_write);
 			m_sock_write = INVALID_SOCKET;
 			throw std::runtime_error(std::string(FUNCNAME) + ": connect failed: " + error_msg);
 		}
+		if (!m_simulate)
+		{
+			if (epicsThreadCreate("daedataRecv", epicsThreadPriorityHigh, epicsThreadGetStackSize(epicsThreadStackSmall),
+			                      (EPICSTHREADFUNC)receiveThreadC, this) == 0)
+			{
+				throw std::runtime_error(std::string(FUNCNAME) + ": epicsThreadCreate failure");
+			}
+			m_receive_thread = true;
+		}
 	}
 	
 	DAEDataUDP::~DAEDataUDP()
 	{
-		if (INVALID_SOCKET != m_sock_read)
+		m_exiting = true;
+		if (m_receive_thread)
 		{
-			epicsSocketDestroy(m_sock_read);
-			m_sock_read = INVALID_SOCKET;
+			m_receive_done.wait();
+		}
+		for(int c=0; c<NumChannels; ++c)
+		{
+			if (INVALID_SOCKET != m_channels[c].sock)
+			{
+				epicsSocketDestroy(m_channels[c].sock);
+				m_channels[c].sock = INVALID_SOCKET;
+			}
 		}
 		if (INVALID_SOCKET != m_sock_write)
 		{
@@ -152,175 +198,762 @@ static const std::string FUNCNAME = "DAEDataUDP";
 		}
 	}
 	
-    void DAEDataUDP::clearSocket(SOCKET fd, asynUser *pasynUser)
-	{	
-		int n = 1; 
-		char buffer[2048];
-		fd_set reply_fds;
-		struct timeval no_delay;
-		struct sockaddr_in reply_sa;
-		socklen_t reply_sa_len;
-		while (n > 0)
-		{
-			no_delay.tv_sec = no_delay.tv_usec = 0;
-			FD_ZERO(&reply_fds);
-			FD_SET(fd, &reply_fds);
-			reply_sa_len = sizeof(reply_sa);
-			if ( select((int)fd + 1, &reply_fds, NULL, NULL, &no_delay) > 0 ) // nfds parameter is ignored on Windows, so cast to avoid warning
+	/// \return a socket bound to an ephemeral port and connected to the DAE read port, for a channel's requests and their replies
+	SOCKET DAEDataUDP::openReadSocket()
+	{
+		SOCKET sock = epicsSocketCreate(PF_INET, SOCK_DGRAM, 0);
+		if (sock == INVALID_SOCKET)
+		{
+			throw std::runtime_error(std::string(FUNCNAME) + ": Can't create recv socket: " + socket_errmsg());
+		}
+		if (bind(sock, (struct sockaddr *) &m_sa_read_recv, sizeof(m_sa_read_recv)) < 0)
+		{
+			std::string error_msg = socket_errmsg();  // before calling epicsSocketDestroy
+			epicsSocketDestroy(sock);
+			throw std::runtime_error(std::string(FUNCNAME) + ": bind failed: " + error_msg);
+		}
+		if (connect(sock, (struct sockaddr *) &m_sa_read_send, sizeof(m_sa_read_send)) < 0)
+		{
+			std::string error_msg = socket_errmsg();  // before calling epicsSocketDestroy
+			epicsSocketDestroy(sock);
+			throw std::runtime_error(std::string(FUNCNAME) + ": connect failed: " + error_msg);
+		}
+		return sock;
+	}
+
+    void DAEDataUDP::readData(unsigned int start_address, uint32_t* data, size_t block_size, asynUser *pasynUser, Channel channel)
+	{
+		Block block = { start_address, data, block_size, Words32, 0 };
+		readBlocks(&block, 1, pasynUser, channel);
+	}
+
+	/// read into a buffer laid out as format, e.g. the epicsInt16 array of a waveform record
+	/// \param offset added to each element
+    void DAEDataUDP::readData(unsigned int start_address, void* data, size_t block_size, Format format, uint32_t offset, asynUser *pasynUser, Channel channel)
+	{
+		Block block = { start_address, data, block_size, format, offset };
+		readBlocks(&block, 1, pasynUser, channel);
+	}
+
+	/// bytes of a caller's buffer taken up by each DAE word in format
+	size_t DAEDataUDP::formatBytes(Format format)
+	{
+		return (format == Low16 ? 2 : 4);
+	}
+
+	/// read several separate blocks of memory, all sharing the channel's window of in flight requests.
+	/// Replies are decoded into the blocks by the receive thread, we just keep the window full and retransmit
+	/// anything overdue. A request is retransmitted after pasynUser->timeout seconds if set, otherwise the default timeout.
+	/// With adaptive timeouts it is retransmitted after the current estimate instead, backing off up to the longest of
+	/// MAX_RTO, the configured timeout and pasynUser->timeout
+    void DAEDataUDP::readBlocks(const Block* blocks, size_t nblocks, asynUser *pasynUser, Channel channel)
+	{
+		ReadChannel& ch = m_channels[channel];
+		epicsGuard<epicsMutex> _lock(ch.lock);
+		if (m_simulate)
+		{
+			for(size_t j=0; j<nblocks; ++j)
 			{
-				n = recvfrom(fd, buffer, sizeof(buffer), 0, (struct sockaddr *)&reply_sa, &reply_sa_len);
-				asynPrint(pasynUser, ASYN_TRACE_FLOW, "discarded %d bytes from %s port %hu ", n, inet_ntoa(reply_sa.sin_addr), ntohs(reply_sa.sin_port));
+				for(size_t i=0; i<blocks[j].block_size; ++i)
+				{
+					uint32_t word = htonl(blocks[j].start_address + 4 * (uint32_t)i);
+					decodeWords(&word, 1, blocks[j].format, blocks[j].offset, (char*)blocks[j].data + i * formatBytes(blocks[j].format));
+				}
 			}
-			else
+			return;
+		}
+		checkLink(pasynUser, (nblocks > 0 ? blocks[0].start_address : 0));
+		// split into the largest blocks the protocol allows, unless the firmware needs word at a time
+		size_t chunk_size = (m_word_reads ? 1 : MAX_BLOCK_SIZE);
+		size_t iblock = 0, offset = 0, inflight = 0;
+		try
+		{
+			// keep up to m_requests.size() requests in flight, replies may complete in any order
+			while(true)
 			{
-			    n = 0;
+				{
+					epicsGuard<epicsMutex> _rlock(m_request_lock);
+					double user_timeout = (pasynUser != NULL && pasynUser->timeout > 0.0 ? pasynUser->timeout : 0.0);
+					double timeout = (m_adaptive ? m_stats.rto : (user_timeout > 0.0 ? user_timeout : m_timeout));
+					double max_timeout = (m_adaptive ? std::max(m_max_rto, user_timeout) : timeout);
+					ch.active_user = pasynUser;
+					for(size_t i=ch.first; i<ch.first+ch.count; ++i)
+					{
+						ReadRequest& req = m_requests[i];
+						if (req.state == ReadRequest::Failed)
+						{
+							readSizeError(req, pasynUser);
+						}
+						if (req.state == ReadRequest::Done)
+						{
+							req.state = ReadRequest::Free;
+							--inflight;
+						}
+						while(iblock < nblocks && offset >= blocks[iblock].block_size)
+						{
+							++iblock;
+							offset = 0;
+						}
+						if (iblock < nblocks && req.state == ReadRequest::Free)
+						{
+							req.state = ReadRequest::Busy;
+							req.start_address = blocks[iblock].start_address + 4 * offset;
+							req.data = (char*)blocks[iblock].data + offset * formatBytes(blocks[iblock].format);
+							req.format = blocks[iblock].format;
+							req.offset = blocks[iblock].offset;
+							req.block_size = std::min(chunk_size, blocks[iblock].block_size - offset);
+							req.timeout = timeout;
+							req.max_timeout = max_timeout;
+							req.retries = 0;
+							sendReadRequest(req, pasynUser);
+							offset += req.block_size;
+							++inflight;
+						}
+					}
+				}
+				if (inflight == 0)
+				{
+					break;
+				}
+				ch.reply_event.wait(retransmitExpired(channel, pasynUser));
 			}
 		}
+		catch(...)
+		{
+			cancelRequests(channel);
+			throw;
+		}
+		cancelRequests(channel);
 	}
 
-    void DAEDataUDP::readData(unsigned int start_address, uint32_t* data, size_t block_size, asynUser *pasynUser)
+	/// forget all of a channel's in flight requests so the receive thread no longer writes to their buffers
+    void DAEDataUDP::cancelRequests(Channel channel)
 	{
-		epicsGuard<epicsMutex> _lock(m_read_lock);
-		for(int i=0; i<block_size; ++i)
+		epicsGuard<epicsMutex> _rlock(m_request_lock);
+		ReadChannel& ch = m_channels[channel];
+		for(size_t i=ch.first; i<ch.first+ch.count; ++i)
 		{
-		    readDataImpl(start_address + 4 * i, data + i, 1, pasynUser);
+			m_requests[i].state = ReadRequest::Free;
 		}
+		ch.active_user = NULL;
 	}
-	
-    void DAEDataUDP::readDataImpl(unsigned int start_address, uint32_t* data, size_t block_size, asynUser *pasynUser)
+
+	/// send (or resend) the read_send datagram for a request and set its reply deadline
+    void DAEDataUDP::sendReadRequest(ReadRequest& req, asynUser *pasynUser)
 	{
-		std::ostringstream error_message;
-		if (block_size <= 0 || block_size > MAX_BLOCK_SIZE)
+		if (req.block_size <= 0 || req.block_size > MAX_BLOCK_SIZE)
 		{
-			error_message << FUNCNAME << ": Block size error " << block_size;
-			asynPrint(pasynUser, ASYN_TRACE_ERROR, error_message.str().c_str());
-			throw std::runtime_error(error_message.str());
+			fail(pasynUser, DAEDataError(DAEDataError::BlockSize, req.start_address, MAX_BLOCK_SIZE, (unsigned long)req.block_size));
 		}
-		if (m_simulate)
+		read_send rs(req.start_address, (int16_t)req.block_size);
+		int stat = send(m_channels[req.channel].sock, (char*)&rs, sizeof(rs), 0);
+		if (stat < 0)
+		{
+			DAEDataError error(DAEDataError::SendFailed, req.start_address);
+			count(m_counters.send_errors);
+			fail(pasynUser, error);
+		}
+		else if (stat != sizeof(rs))
+		{
+			count(m_counters.send_errors);
+			fail(pasynUser, DAEDataError(DAEDataError::SendSize, req.start_address, sizeof(rs), stat));
+		}
+		req.sent = epicsTime::getCurrent();
+		req.deadline = req.sent + req.timeout;
+		count(m_counters.read_requests);
+	}
+
+	/// a reply of the wrong size arrived for a request
+    void DAEDataUDP::readSizeError(const ReadRequest& req, asynUser *pasynUser)
+	{
+		fail(pasynUser, DAEDataError(DAEDataError::ReplySize, req.start_address, (unsigned long)(6 + 4 * req.block_size), req.received));
+	}
+
+	/// resend any of a channel's in flight requests whose reply is overdue, failing once they have used up their retries.
+	/// Adaptive timeouts double with each retransmission, up to the request's max_timeout
+	/// \return seconds until the next in flight request is due to be retransmitted
+    double DAEDataUDP::retransmitExpired(Channel channel, asynUser *pasynUser)
+	{
+		epicsGuard<epicsMutex> _rlock(m_request_lock);
+		const ReadChannel& ch = m_channels[channel];
+		epicsTime now = epicsTime::getCurrent();
+		double wait = m_timeout;
+		for(size_t i=ch.first; i<ch.first+ch.count; ++i)
+		{
+			ReadRequest& req = m_requests[i];
+			if (req.state == ReadRequest::Busy && !(now < req.deadline))
+			{
+				if (req.retries >= m_max_retries)
+				{
+					count(m_counters.timeouts);
+					fail(pasynUser, DAEDataError(DAEDataError::Timeout, req.start_address));
+				}
+				++req.retries;
+				count(m_counters.retransmits);
+				if (m_adaptive)
+				{
+					req.timeout = std::min(2.0 * req.timeout, req.max_timeout);
+				}
+				asynPrint(pasynUser, ASYN_TRACE_FLOW, "retransmitting read of address 0x%x (retry %d) ", req.start_address, req.retries);
+				sendReadRequest(req, pasynUser);
+			}
+			if (req.state == ReadRequest::Busy)
+			{
+				wait = std::min(wait, req.deadline - now);
+			}
+			else if (req.state != ReadRequest::Free)
+			{
+				wait = 0.0;  // completed while we were busy
+			}
+		}
+		return std::max(wait, 0.0);
+	}
+
+    void DAEDataUDP::receiveThreadC(void* arg)
+	{
+		DAEDataUDP* udp = (DAEDataUDP*)arg;
+		udp->receiveThread();
+	}
+
+	/// wait for replies on the channels' read sockets and hand each one to the request it answers
+    void DAEDataUDP::receiveThread()
+	{
+		std::vector<read_recv> rr(RECV_BATCH);
+		int stat;
+		while(!m_exiting)
+		{
+			if (epicsAtomicGetIntT(&m_link_down) && !(epicsTime::getCurrent() < m_next_probe))
+			{
+				sendProbe();
+				m_next_probe = epicsTime::getCurrent() + PROBE_PERIOD;
+			}
+			struct pollfd pfd[NumChannels];
+			for(int c=0; c<NumChannels; ++c)
+			{
+				pfd[c].fd = m_channels[c].sock;
+				pfd[c].events = POLLIN;
+				pfd[c].revents = 0;
+			}
+#ifdef _WIN32
+			stat = WSAPoll(pfd, NumChannels, RECV_POLL_MS);
+#else
+			stat = poll(pfd, NumChannels, RECV_POLL_MS);
+#endif
+			if (stat <= 0 || m_exiting)
+			{
+				if (stat < 0)
+				{
+					epicsThreadSleep(0.1);  // e.g. EINTR, do not spin
+				}
+				continue;
+			}
+			for(int c=0; c<NumChannels; ++c)
+			{
+				if (pfd[c].revents != 0)
+				{
+					receiveReplies((Channel)c, rr);
+				}
+			}
+		}
+		m_receive_done.signal();
+	}
+
+	/// take the replies waiting on a channel's socket. On Linux recvmmsg() takes up to RECV_BATCH datagrams 
+	/// per system call when a burst of replies arrives together
+    void DAEDataUDP::receiveReplies(Channel channel, std::vector<read_recv>& rr)
+	{
+		int stat;
+		SOCKET sock = m_channels[channel].sock;
+#if defined(__linux__)
+		struct mmsghdr msgs[RECV_BATCH];
+		struct iovec iovecs[RECV_BATCH];
+		for(int i=0; i<RECV_BATCH; ++i)
+		{
+			iovecs[i].iov_base = &(rr[i]);
+			iovecs[i].iov_len = sizeof(rr[i]);
+			memset(&(msgs[i]), 0, sizeof(msgs[i]));
+			msgs[i].msg_hdr.msg_iov = &(iovecs[i]);
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+		stat = recvmmsg(sock, msgs, RECV_BATCH, MSG_DONTWAIT, NULL);
+		for(int i=0; i<stat; ++i)
+		{
+			dispatchReply(channel, rr[i], msgs[i].msg_len);
+		}
+#else
+		stat = recv(sock, (char*)&(rr[0]), sizeof(rr[0]), 0);
+		if (stat >= 0)
+		{
+			dispatchReply(channel, rr[0], stat);
+		}
+#endif
+	}
+
+	/// decode a reply into the in flight request of the channel it arrived on that it matches by start address and block size, 
+	/// the one sent longest ago if several match. Anything else (e.g. a late reply to a request since retransmitted) is counted 
+	/// as stale and dropped. The read sockets are connected to the DAE so only its datagrams arrive here
+    void DAEDataUDP::dispatchReply(Channel channel, const read_recv& rr, int size)
+	{
+		epicsGuard<epicsMutex> _rlock(m_request_lock);
+		unsigned start_address = (size >= 6 ? ntohl(rr.start_addr) : 0);
+		size_t block_size = (size >= 6 ? ntohs(rr.block_size) : 0);
+		bool probe_reply = false;
+		if (size >= 6 && size == (int)(6 + 4 * block_size))
+		{
+			// the board is answering
+			epicsAtomicSetIntT(&m_timeouts, 0);
+			m_probe_address = start_address;
+			if (epicsAtomicGetIntT(&m_link_down))
+			{
+				linkUp();
+				probe_reply = true;
+			}
+		}
+		ReadChannel& ch = m_channels[channel];
+		ReadRequest* req = NULL;
+		for(size_t i=ch.first; i<ch.first+ch.count && size >= 6; ++i)
+		{
+			if (m_requests[i].state == ReadRequest::Busy && m_requests[i].start_address == start_address && m_requests[i].block_size == block_size &&
+			    (req == NULL || m_requests[i].sent < req->sent))
+			{
+				req = &(m_requests[i]);
+			}
+		}
+		if (req == NULL && probe_reply)
 		{
-		    for(int i=0; i<block_size; ++i)
-		    {
-		        data[i] = start_address + 4 * i;
-		    }
 			return;
 		}
-		read_send rs(start_address, block_size);
-		read_recv rr;
-		clearSocket(m_sock_read, pasynUser);
-		int stat = send(m_sock_read, (char*)&rs, sizeof(rs), 0);
-		if (stat < 0)
+		if (req == NULL)
+		{
+			count(m_counters.stale);
+			if (ch.active_user != NULL)
+			{
+				asynPrint(ch.active_user, ASYN_TRACE_FLOW, "discarded stale %d byte reply for address 0x%x block size %u ", size, start_address, (unsigned)block_size);
+			}
+			return;
+		}
+		req->received = size;
+		if (size != (int)(6 + 4 * block_size))
 		{
-			error_message << FUNCNAME << ": cannot send: " << socket_errmsg();
-			asynPrint(pasynUser, ASYN_TRACE_ERROR, error_message.str().c_str());
-			throw std::runtime_error(error_message.str());
+			count(m_counters.size_errors);
+			req->state = ReadRequest::Failed;
 		}
-		else if (stat != sizeof(rs))
+		else
 		{
-			error_message << FUNCNAME << ": send size error: " << stat << " != " << sizeof(rs);
-			asynPrint(pasynUser, ASYN_TRACE_ERROR, error_message.str().c_str());
-			throw std::runtime_error(error_message.str());
-		}
-		fd_set reply_fds;
-		struct timeval wait_time;
-		FD_ZERO(&reply_fds);
-		FD_SET(m_sock_read, &reply_fds);
-		wait_time.tv_sec = 5;
-		wait_time.tv_usec = 0;
-		struct sockaddr_in reply_sa;
-		socklen_t reply_sa_len = sizeof(reply_sa);
-		stat = select((int)m_sock_read + 1, &reply_fds, NULL, NULL, &wait_time); // nfds parameter is ignored on Windows, so cast to avoid warning 
-		if (stat == 0) 
-		{
-			error_message << FUNCNAME << ": select timeout reading address 0x" << std::hex << start_address;
-			asynPrint(pasynUser, ASYN_TRACE_ERROR, error_message.str().c_str());
-			throw std::runtime_error(error_message.str());
-		} 
-		else if (stat < 0)
-		{
-			error_message << FUNCNAME << ": cannot select: " << socket_errmsg();
-			asynPrint(pasynUser, ASYN_TRACE_ERROR, error_message.str().c_str());
-			throw std::runtime_error(error_message.str());
-		}
-		stat = recvfrom(m_sock_read, (char*)&rr, sizeof(rr), 0, (struct sockaddr *)&reply_sa, &reply_sa_len);
-		if (stat < 0)
+			decodeWords(rr.data, block_size, req->format, req->offset, req->data);
+			req->state = ReadRequest::Done;
+			count(m_counters.read_bytes, size);
+			if (req->retries == 0)
+			{
+				// Karn's algorithm: a retransmitted request's reply could be to either send, so do not time it
+				double rtt = epicsTime::getCurrent() - req->sent;
+				int bucket = 0;
+				while(bucket < RTT_BUCKETS - 1 && rtt >= RTT_LIMITS[bucket])
+				{
+					++bucket;
+				}
+				count(m_counters.rtt[bucket]);
+				updateRTT(rtt);
+			}
+		}
+		ch.reply_event.signal();
+	}
+
+	/// set the seconds before an unanswered read is retransmitted (where adaptive timeouts start from) 
+	/// and how many times it is retransmitted, 0 or negative to leave unchanged/at their defaults.
+	/// A timeout longer than MAX_RTO also becomes the ceiling adaptive timeouts back off to. 
+	/// The round trip time measured so far is kept, the timeout only restarts from the new value if there is none
+    void DAEDataUDP::setTimeout(double timeout, int retries)
+	{
+		epicsGuard<epicsMutex> _rlock(m_request_lock);
+		if (timeout > 0.0)
+		{
+			m_timeout = timeout;
+		}
+		if (retries >= 0)
+		{
+			m_max_retries = retries;
+		}
+		m_max_rto = std::max(m_timeout, MAX_RTO);
+		m_stats.adaptive = m_adaptive;
+		if (!m_adaptive)
+		{
+			m_stats.rto = m_timeout;
+		}
+		else if (m_stats.rtt_samples == 0)
 		{
-			error_message << FUNCNAME << ": cannot recvfrom: " << socket_errmsg();
-			asynPrint(pasynUser, ASYN_TRACE_ERROR, error_message.str().c_str());
-			throw std::runtime_error(error_message.str());
+			m_stats.rto = std::min(std::max(m_timeout, MIN_RTO), m_max_rto);
 		}
-		else if (stat != 6+4*block_size)
+		else
 		{
-			error_message << FUNCNAME << ": recvfrom incorrect size: " << stat << " != " << 6+4*block_size << " for address 0x" << std::hex << start_address;
-			asynPrint(pasynUser, ASYN_TRACE_ERROR, error_message.str().c_str());
-			throw std::runtime_error(error_message.str());
+			m_stats.rto = std::min(std::max(m_stats.srtt + 4.0 * m_stats.rttvar, MIN_RTO), m_max_rto);
 		}
-//		if (reply_sa.sin_port != htons(10002) reply from wrong port
-		if (reply_sa.sin_addr.s_addr != m_sa_read_send.sin_addr.s_addr)
+	}
+
+	/// fold a round trip time measurement into the smoothed RTT and its variance, and work out the 
+	/// retransmit timeout from them as TCP does (RFC 6298). Called with m_request_lock held
+    void DAEDataUDP::updateRTT(double rtt)
+	{
+		if (m_stats.rtt_samples == 0)
+		{
+			m_stats.srtt = rtt;
+			m_stats.rttvar = rtt / 2.0;
+		}
+		else
 		{
-			error_message << FUNCNAME << ": reply from wrong host " << inet_ntoa(reply_sa.sin_addr);
-			asynPrint(pasynUser, ASYN_TRACE_ERROR, error_message.str().c_str());
-			throw std::runtime_error(error_message.str());
+			m_stats.rttvar = 0.75 * m_stats.rttvar + 0.25 * fabs(m_stats.srtt - rtt);
+			m_stats.srtt = 0.875 * m_stats.srtt + 0.125 * rtt;
 		}
-		if (rr.start_addr != rs.start_addr)
+		++m_stats.rtt_samples;
+		if (m_adaptive)
 		{
-			error_message << FUNCNAME << ": Mismatch in returned memory start addresss";
-			asynPrint(pasynUser, ASYN_TRACE_ERROR, error_message.str().c_str());
-			throw std::runtime_error(error_message.str());
+			m_stats.rto = std::min(std::max(m_stats.srtt + 4.0 * m_stats.rttvar, MIN_RTO), m_max_rto);
 		}
-		if (rr.block_size != rs.block_size)
+	}
+
+	/// \return a copy of the round trip time estimate
+    void DAEDataUDP::getStats(Stats& stats)
+	{
+		epicsGuard<epicsMutex> _rlock(m_request_lock);
+		stats = m_stats;
+	}
+
+	DAEDataUDP::Counters::Counters() : read_requests(0), read_bytes(0), retransmits(0), timeouts(0), stale(0), size_errors(0),
+	    write_requests(0), write_bytes(0), send_errors(0), verify_rereads(0), verify_failures(0), rejected(0)
+	{
+		for(int i=0; i<RTT_BUCKETS; ++i)
 		{
-			error_message << FUNCNAME << ": Mismatch in returned block size";
-			asynPrint(pasynUser, ASYN_TRACE_ERROR, error_message.str().c_str());
-			throw std::runtime_error(error_message.str());
+			rtt[i] = 0;
 		}
-		rr.flip_endian();
-		for(int i=0; i<block_size; ++i)
+	}
+
+	/// add to one of m_counters, from whichever thread
+    void DAEDataUDP::count(size_t& counter, size_t n)
+	{
+		epicsAtomicAddSizeT(&counter, n);
+	}
+
+	/// \return a snapshot of the link counters, each read atomically though not all at the same instant
+    void DAEDataUDP::getCounters(Counters& counters)
+	{
+		counters.read_requests = epicsAtomicGetSizeT(&m_counters.read_requests);
+		counters.read_bytes = epicsAtomicGetSizeT(&m_counters.read_bytes);
+		counters.retransmits = epicsAtomicGetSizeT(&m_counters.retransmits);
+		counters.timeouts = epicsAtomicGetSizeT(&m_counters.timeouts);
+		counters.stale = epicsAtomicGetSizeT(&m_counters.stale);
+		counters.size_errors = epicsAtomicGetSizeT(&m_counters.size_errors);
+		counters.write_requests = epicsAtomicGetSizeT(&m_counters.write_requests);
+		counters.write_bytes = epicsAtomicGetSizeT(&m_counters.write_bytes);
+		counters.send_errors = epicsAtomicGetSizeT(&m_counters.send_errors);
+		counters.verify_rereads = epicsAtomicGetSizeT(&m_counters.verify_rereads);
+		counters.verify_failures = epicsAtomicGetSizeT(&m_counters.verify_failures);
+		counters.rejected = epicsAtomicGetSizeT(&m_counters.rejected);
+		for(int i=0; i<RTT_BUCKETS; ++i)
 		{
-		    data[i] = rr.data[i];
+			counters.rtt[i] = epicsAtomicGetSizeT(&m_counters.rtt[i]);
 		}
 	}
 
-    void DAEDataUDP::writeData(unsigned int start_address, const uint32_t* data, size_t block_size, bool verify, asynUser *pasynUser)
+	/// \return a copy of the link state
+    void DAEDataUDP::getLinkState(LinkState& link)
+	{
+		epicsGuard<epicsMutex> _llock(m_link_lock);
+		link = m_link;
+		link.timeouts = epicsAtomicGetIntT(&m_timeouts);
+	}
+
+	/// record an error in the link state, trace it and throw it. Only one error is traced per ERROR_LOG_PERIOD,
+	/// so a link outage failing every record's reads does not flood the log, the rest are counted and the count 
+	/// traced with the next. Reads timing out or their sends failing take the link down, see LinkState
+    void DAEDataUDP::fail(asynUser *pasynUser, const DAEDataError& error)
+	{
+		bool trace = false, down = false;
+		unsigned long suppressed = 0;
+		{
+			epicsGuard<epicsMutex> _llock(m_link_lock);
+			epicsTime now = epicsTime::getCurrent();
+			m_link.last_error = error.code;
+			m_link.last_errno = error.sys_errno;
+			if (error.code == DAEDataError::Timeout || error.code == DAEDataError::SendFailed)
+			{
+				// e.g. ECONNREFUSED after an ICMP port unreachable counts as no answer too
+				if (epicsAtomicIncrIntT(&m_timeouts) >= LINK_DOWN_TIMEOUTS && m_link.up)
+				{
+					m_link.up = false;
+					m_link.changed = now;
+					epicsAtomicSetIntT(&m_link_down, 1);
+					down = true;
+				}
+			}
+			if (now - m_last_log >= ERROR_LOG_PERIOD)
+			{
+				trace = true;
+				suppressed = m_log_suppressed;
+				m_log_suppressed = 0;
+				m_last_log = now;
+			}
+			else
+			{
+				++m_log_suppressed;
+			}
+		}
+		if (suppressed > 0)
+		{
+			asynPrint(pasynUser, ASYN_TRACE_ERROR, "%s: %lu more errors not traced\n", FUNCNAME.c_str(), suppressed);
+		}
+		if (trace)
+		{
+			asynPrint(pasynUser, ASYN_TRACE_ERROR, "%s\n", error.what());
+		}
+		if (down)
+		{
+			errlogSevPrintf(errlogMajor, "%s: %s is not answering, link down after %d reads in a row timed out or could not be sent\n", FUNCNAME.c_str(), m_host.c_str(), LINK_DOWN_TIMEOUTS);
+		}
+		throw error;
+	}
+
+	/// fail at once if the link is down
+    void DAEDataUDP::checkLink(asynUser *pasynUser, unsigned start_address)
+	{
+		if (epicsAtomicGetIntT(&m_link_down))
+		{
+			count(m_counters.rejected);
+			fail(pasynUser, DAEDataError(DAEDataError::LinkDown, start_address));
+		}
+	}
+
+	/// a reply has arrived while the link was down. Called by the receive thread with m_request_lock held
+    void DAEDataUDP::linkUp()
+	{
+		{
+			epicsGuard<epicsMutex> _llock(m_link_lock);
+			if (m_link.up)
+			{
+				return;
+			}
+			m_link.up = true;
+			m_link.changed = epicsTime::getCurrent();
+			epicsAtomicSetIntT(&m_link_down, 0);
+		}
+		errlogSevPrintf(errlogInfo, "%s: %s is answering again, link up\n", FUNCNAME.c_str(), m_host.c_str());
+	}
+
+	/// read one word at the last address the board answered, not one that timed out as that may be an address the 
+	/// firmware ignores, any reply brings the link back up. Called by the receive thread
+    void DAEDataUDP::sendProbe()
+	{
+		read_send rs(m_probe_address, 1);
+		send(m_channels[BulkChannel].sock, (char*)&rs, sizeof(rs), 0);
+	}
+
+	/// \return the upper bound in seconds of a round trip time histogram bucket, 0 for the last which has none
+    double DAEDataUDP::rttBucketLimit(int bucket)
+	{
+		return (bucket >= 0 && bucket < RTT_BUCKETS - 1 ? RTT_LIMITS[bucket] : 0.0);
+	}
+
+    void DAEDataUDP::writeData(unsigned int start_address, const uint32_t* data, size_t block_size, bool verify, asynUser *pasynUser, DeferredVerify* deferred)
+	{
+		writeData(start_address, data, block_size, Words32, 0, verify, pasynUser, deferred);
+	}
+
+	/// write from a buffer laid out as format, encoding straight into the datagrams
+	/// \param offset subtracted from each element
+    void DAEDataUDP::writeData(unsigned int start_address, const void* data, size_t block_size, Format format, uint32_t offset, bool verify, asynUser *pasynUser, DeferredVerify* deferred)
 	{
 		epicsGuard<epicsMutex> _lock(m_write_lock);
-		std::ostringstream error_message;
-		if (block_size <= 0 || block_size > MAX_BLOCK_SIZE)
+		if (block_size <= 0)
 		{
-			error_message << FUNCNAME << ": Block size error";
-			asynPrint(pasynUser, ASYN_TRACE_ERROR, error_message.str().c_str());
-			throw std::runtime_error(error_message.str());
+			fail(pasynUser, DAEDataError(DAEDataError::WriteBlockSize, start_address, MAX_BLOCK_SIZE, (unsigned long)block_size));
 		}
 		if (m_simulate)
 		{
 			return;
 		}
-		write_send ws(start_address, block_size, data);
+		checkLink(pasynUser, start_address);
+		// send all the datagrams back to back, then check them with one pipelined read
+		for(size_t i=0; i<block_size; i += MAX_BLOCK_SIZE)
+		{
+			sendWriteRequest(start_address + 4 * i, (const char*)data + i * formatBytes(format), format, offset, std::min((size_t)MAX_BLOCK_SIZE, block_size - i), pasynUser);
+		}
+		if (!verify)
+		{
+			return;
+		}
+		if (deferred != NULL)
+		{
+			deferred->add(start_address, data, format, offset, block_size);
+			return;
+		}
+		m_verify_buffer.resize(block_size);
+		readData(start_address, &(m_verify_buffer[0]), block_size, pasynUser, InteractiveChannel);
+		std::vector<Mismatch> mismatches;
+		checkVerify(start_address, data, format, offset, &(m_verify_buffer[0]), block_size, pasynUser, &mismatches);
+		for(int i=0; i<VERIFY_REREADS && !mismatches.empty(); ++i)
+		{
+			// replies carry no sequence number, so a late or duplicated reply to an earlier read of 
+			// the same block looks just like the answer. Let any stragglers arrive and look again
+			count(m_counters.verify_rereads);
+			waitForStragglers();
+			readData(start_address, &(m_verify_buffer[0]), block_size, pasynUser, InteractiveChannel);
+			mismatches.clear();
+			checkVerify(start_address, data, format, offset, &(m_verify_buffer[0]), block_size, pasynUser, (i + 1 < VERIFY_REREADS ? &mismatches : NULL));
+		}
+	}
+
+	/// read-modify-write of a block: only the bits set in mask are changed, to those of data, and only the runs
+	/// of words that then differ from what was read are written. The read and the writes are made holding the
+	/// write lock, so no other write through this DAEDataUDP can land in between and be undone by ours.
+	/// The writes are sent back to back and verified with one batch of reads, as verifyDeferred()
+	/// \param[out] result if not NULL, the block_size words as now written
+	/// \return the number of words written
+    size_t DAEDataUDP::writeMasked(unsigned int start_address, const uint32_t* data, const uint32_t* mask, size_t block_size, bool verify, asynUser *pasynUser, uint32_t* result)
+	{
+		epicsGuard<epicsMutex> _lock(m_write_lock);
+		if (block_size <= 0)
+		{
+			fail(pasynUser, DAEDataError(DAEDataError::WriteBlockSize, start_address, MAX_BLOCK_SIZE, (unsigned long)block_size));
+		}
+		m_rmw_buffer.resize(block_size);
+		uint32_t* words = &(m_rmw_buffer[0]);
+		readData(start_address, words, block_size, pasynUser, InteractiveChannel);
+		DeferredVerify deferred;
+		size_t nwritten = 0;
+		for(size_t i=0; i<block_size; )
+		{
+			uint32_t word = (words[i] & ~mask[i]) | (data[i] & mask[i]);
+			if (word == words[i])
+			{
+				++i;
+				continue;
+			}
+			size_t first = i;
+			for(; i<block_size && ((words[i] & ~mask[i]) | (data[i] & mask[i])) != words[i]; ++i)
+			{
+				words[i] = (words[i] & ~mask[i]) | (data[i] & mask[i]);
+			}
+			writeData(start_address + 4 * (unsigned)first, words + first, i - first, verify, pasynUser, &deferred);
+			nwritten += i - first;
+		}
+		if (!deferred.empty())
+		{
+			verifyDeferred(deferred, pasynUser);
+		}
+		if (result != NULL)
+		{
+			std::copy(words, words + block_size, result);
+		}
+		return nwritten;
+	}
+
+	/// wait for replies to requests we have finished with to arrive and be discarded as stale, for twice the
+	/// retransmit timeout but at most MAX_STRAGGLER_WAIT. The wait is made holding m_write_lock, so that no other write 
+	/// can change the block before it is read again, which is why it is bounded rather than following a backed off timeout
+    void DAEDataUDP::waitForStragglers()
+	{
+		double rto;
+		{
+			epicsGuard<epicsMutex> _rlock(m_request_lock);
+			rto = m_stats.rto;
+		}
+		epicsThreadSleep(std::min(2.0 * rto, MAX_STRAGGLER_WAIT));
+	}
+
+	/// do the readback for writes made with a DeferredVerify, all as one batch of reads.
+	/// The deferred list is emptied whether or not the verify succeeds.
+	/// \param[out] mismatches if not NULL, every word that did not verify is added here instead of throwing at the first
+    void DAEDataUDP::verifyDeferred(DeferredVerify& deferred, asynUser *pasynUser, std::vector<Mismatch>* mismatches)
+	{
+		epicsGuard<epicsMutex> _lock(m_write_lock);
+		std::vector<Block> blocks(deferred.m_blocks);
+		std::vector<uint32_t> expected;
+		expected.swap(deferred.m_expected);
+		deferred.m_blocks.clear();
+		if (m_simulate || blocks.empty())
+		{
+			return;
+		}
+		m_verify_buffer.resize(expected.size());
+		for(size_t i=0, offset=0; i<blocks.size(); offset += blocks[i].block_size, ++i)
+		{
+			blocks[i].data = &(m_verify_buffer[offset]);
+			blocks[i].format = Words32;
+			blocks[i].offset = 0;
+		}
+		readBlocks(&(blocks[0]), blocks.size(), pasynUser, InteractiveChannel);
+		std::vector<Mismatch> found;
+		for(int reread=0; ; ++reread)
+		{
+			bool last = (reread == VERIFY_REREADS);
+			size_t nmismatches = (mismatches != NULL ? mismatches->size() : 0);
+			found.clear();
+			for(size_t i=0, offset=0; i<blocks.size(); offset += blocks[i].block_size, ++i)
+			{
+				checkVerify(blocks[i].start_address, &(expected[offset]), Words32, 0, &(m_verify_buffer[offset]), blocks[i].block_size, pasynUser, 
+				            (last ? mismatches : &found));
+			}
+			if (last && mismatches != NULL && mismatches->size() > nmismatches)
+			{
+				count(m_counters.verify_failures);
+			}
+			if (last || found.empty())
+			{
+				break;
+			}
+			// as in writeData(), a stale reply could have been taken for the readback
+			count(m_counters.verify_rereads);
+			waitForStragglers();
+			readBlocks(&(blocks[0]), blocks.size(), pasynUser, InteractiveChannel);
+		}
+	}
+
+	/// send one write_send datagram of at most MAX_BLOCK_SIZE words
+    void DAEDataUDP::sendWriteRequest(unsigned int start_address, const void* data, Format format, uint32_t offset, size_t block_size, asynUser *pasynUser)
+	{
+		write_send ws(start_address, (int16_t)block_size);
+		encodeWords(data, format, offset, block_size, ws.data);
 		int stat = send(m_sock_write, (char*)&ws, ws.byteSize(), 0);
 		if (stat < 0)
 		{
-			error_message << FUNCNAME << ": cannot sendto: " << socket_errmsg();
-			asynPrint(pasynUser, ASYN_TRACE_ERROR, error_message.str().c_str());
-			throw std::runtime_error(error_message.str());
+			DAEDataError error(DAEDataError::WriteSendFailed, start_address);
+			count(m_counters.send_errors);
+			fail(pasynUser, error);
 		}
 		else if (stat != ws.byteSize())
 		{
-			error_message << FUNCNAME << ": sendto size error ";
-			asynPrint(pasynUser, ASYN_TRACE_ERROR, error_message.str().c_str());
-			throw std::runtime_error(error_message.str());
+			count(m_counters.send_errors);
+			fail(pasynUser, DAEDataError(DAEDataError::WriteSendSize, start_address, ws.byteSize(), stat));
 		}
-		if (verify)
+		count(m_counters.write_requests);
+		count(m_counters.write_bytes, stat);
+	}
+
+	/// compare words written with those read back, throwing at the first difference unless collecting mismatches
+    void DAEDataUDP::checkVerify(unsigned int start_address, const void* data, Format format, uint32_t offset, const uint32_t* data_rb, size_t block_size, asynUser *pasynUser, std::vector<Mismatch>* mismatches)
+	{
+		for(size_t i=0; i<block_size; ++i)
 		{
-			uint32_t* data_rb = new uint32_t[block_size];
-			readData(start_address, data_rb, block_size, pasynUser);
-			for(int i=0; i<block_size; ++i)
+			uint32_t expected = getWord(data, format, offset, i);
+			if (expected != data_rb[i] && mismatches != NULL)
 			{
-				if (data[i] != data_rb[i])
-				{
-					error_message << FUNCNAME << std::hex << "Verify failed for address 0x" << start_address + 4*i << ": 0x" << data[i] << " != 0x" << data_rb[i] << std::dec;
-					asynPrint(pasynUser, ASYN_TRACE_ERROR, error_message.str().c_str());
-					throw std::runtime_error(error_message.str());
-				}
+				Mismatch m = { start_address + 4 * (unsigned)i, expected, data_rb[i] };
+				mismatches->push_back(m);
+			}
+			else if (expected != data_rb[i])
+			{
+				count(m_counters.verify_failures);
+				fail(pasynUser, DAEDataError(DAEDataError::VerifyFailed, start_address + 4 * (unsigned)i, expected, data_rb[i]));
 			}
-			delete[] data_rb;
+		}
+	}
+
+	/// remember a verified write for DAEDataUDP::verifyDeferred()
+	void DAEDataUDP::DeferredVerify::add(unsigned int start_address, const void* data, Format format, uint32_t offset, size_t block_size)
+	{
+		Block block = { start_address, NULL, block_size, Words32, 0 };
+		m_blocks.push_back(block);
+		for(size_t i=0; i<block_size; ++i)
+		{
+			m_expected.push_back(getWord(data, format, offset, i));
 		}
 	}
@@ -1,25 +1,237 @@
+#ifndef DAEDATAUDP_H
+#define DAEDATAUDP_H
+
+
+#include <string>
+#include <vector>
+#include <stdint.h>
 
 #include "osiSock.h"
+#include "epicsTime.h"
+#include "epicsMutex.h"
+#include "epicsEvent.h"
+#include "asynDriver.h"
+
+#include "daedataProtocol.h"
+#include "daedataError.h"
+
+/// option bits for the DAEDataUDP constructor (and the daedataConfigure options argument)
+enum DAEDataUDPOptions
+{
+    DAEDataUDPWordReads = 0x1,    ///< read one word per datagram rather than in blocks, for firmware that cannot do block reads
+    DAEDataUDPFixedTimeout = 0x2  ///< retransmit reads after a fixed timeout rather than one adapted to the measured round trip time
+};
 
 class DAEDataUDP
 {
+public:
+	/// how the DAE words of a block are laid out in the caller's buffer
+	enum Format
+	{
+		Words32 = 0,        ///< one 32 bit word per element, host byte order
+		Halves16Native,     ///< two 16 bit elements per word, as the host order word lies in memory
+		Halves16HighFirst,  ///< two 16 bit elements per word, high half first
+		Halves16LowFirst,   ///< two 16 bit elements per word, low half first
+		Low16               ///< one 16 bit element per word, the low half (written with the high half zero)
+	};
+	
+	/// Each channel has its own window of read requests in flight, its own lock and its own reply event,
+	/// so a caller on one never waits for a batch of reads on the other. Background reads (the poller, 
+	/// dumps) use BulkChannel; record I/O and the readback of verified writes use InteractiveChannel
+	enum Channel
+	{
+		BulkChannel = 0,
+		InteractiveChannel,
+		NumChannels
+	};
+	
+	/// one block of memory for readBlocks()
+	struct Block
+	{
+		unsigned start_address;
+		void* data;          ///< laid out according to format, e.g. uint32_t* for Words32
+		size_t block_size;   ///< in words
+		Format format;
+		uint32_t offset;     ///< added to each element read, see DAEDataKernels
+	};
+	
+	/// round trip time estimate of the read requests, see updateRTT()
+	struct Stats
+	{
+		unsigned long rtt_samples;  ///< replies timed, i.e. to requests that were not retransmitted
+		double srtt;                ///< smoothed round trip time, seconds
+		double rttvar;              ///< round trip time variation, seconds
+		double rto;                 ///< current retransmit timeout, seconds
+		bool adaptive;
+		Stats() : rtt_samples(0), srtt(0.0), rttvar(0.0), rto(0.0), adaptive(true) { }
+	};
+	
+	enum { RTT_BUCKETS = 9 };   ///< round trip time histogram buckets, see rttBucketLimit()
+	
+	/// link counters since the DAEDataUDP was created. Updated with epicsAtomic operations, so they 
+	/// cost the hot paths no extra locking and getCounters() never waits for a read or write in progress.
+	/// epicsAtomic has no 64 bit operations, so they are size_t: on 32 bit targets they wrap at 2^32, 
+	/// which read_bytes can reach within minutes of bulk reads, and anything trending them must treat a decrease as a wrap
+	struct Counters
+	{
+		size_t read_requests;     ///< read_send datagrams sent, including retransmissions
+		size_t read_bytes;        ///< bytes of read replies accepted
+		size_t retransmits;
+		size_t timeouts;          ///< reads given up after all retries
+		size_t stale;             ///< replies discarded because no request was waiting for them
+		size_t size_errors;       ///< replies of the wrong size for the request they answered
+		size_t write_requests;    ///< write_send datagrams sent
+		size_t write_bytes;
+		size_t send_errors;       ///< read or write datagrams the socket would not send
+		size_t verify_rereads;    ///< write readbacks read again because they did not match
+		size_t verify_failures;   ///< verified writes that still did not match after rereading
+		size_t rejected;          ///< reads and writes failed straight away because the link was down
+		size_t rtt[RTT_BUCKETS];  ///< replies to requests that were not retransmitted, by round trip time
+		Counters();
+	};
+	
+	/// the circuit breaker on the link: after LINK_DOWN_TIMEOUTS reads in a row have timed out (or could not be sent) the link is
+	/// taken to be down, and reads and writes fail at once (DAEDataError::LinkDown) rather than each waiting
+	/// through its retries. Meanwhile the receive thread sends a probe read every PROBE_PERIOD, and the first
+	/// reply of any sort brings the link back up
+	struct LinkState
+	{
+		bool up;
+		int last_error;          ///< DAEDataError::Code of the most recent failure, -1 if none yet
+		int last_errno;          ///< its socket error number, if any
+		int timeouts;            ///< reads timed out (or not sent) in a row, failed write sends do not count
+		epicsTime changed;       ///< when up last changed
+		LinkState() : up(true), last_error(-1), last_errno(0), timeouts(0), changed(epicsTime::getCurrent()) { }
+	};
+	
+	/// a word that did not read back as written
+	struct Mismatch
+	{
+		unsigned address;
+		uint32_t expected;
+		uint32_t actual;
+	};
+	
+	/// verified writes whose readback is put off until verifyDeferred(), so that e.g. a whole 
+	/// configuration upload can be sent back to back and then checked in one batch
+	class DeferredVerify
+	{
+	public:
+		bool empty() const { return m_blocks.empty(); }
+	private:
+		friend class DAEDataUDP;
+		std::vector<Block> m_blocks;
+		std::vector<uint32_t> m_expected;  ///< the data written to all m_blocks, in order
+		void add(unsigned int start_address, const void* data, Format format, uint32_t offset, size_t block_size);
+	};
+
 private:
+	/// a block read that is (or may be) in flight, replies are matched on start address and block size.
+	/// Shared with the receive thread under m_request_lock
+	struct ReadRequest
+	{
+		enum State { Free, Busy, Done, Failed };
+		State state;                ///< Busy once sent, then Done or Failed (wrong size reply) when the receive thread sees its reply
+		Channel channel;            ///< whose window this request slot is part of
+		unsigned start_address;
+		void* data;                 ///< where to decode the reply words
+		Format format;
+		uint32_t offset;
+		size_t block_size;
+		int retries;                ///< number of times this request has been retransmitted
+		double timeout;             ///< seconds to wait for each reply
+		double max_timeout;         ///< adaptive timeouts back off up to this
+		epicsTime sent;             ///< when last sent
+		epicsTime deadline;         ///< when to retransmit if no reply has been seen
+		int received;               ///< size of the reply datagram
+		ReadRequest() : state(Free), channel(BulkChannel), start_address(0), data(NULL), format(Words32), offset(0), block_size(0), retries(0), timeout(0.0), max_timeout(0.0), received(0) { }
+	};
+	
+	/// the state of one Channel
+	struct ReadChannel
+	{
+		epicsMutex lock;            ///< held for the whole of a readBlocks() on the channel
+		size_t first;               ///< its request slots in m_requests
+		size_t count;
+		asynUser* active_user;      ///< for tracing from the receive thread, NULL when no read is in progress. Protected by m_request_lock
+		epicsEvent reply_event;     ///< signalled by the receive thread when one of its requests completes
+		SOCKET sock;                ///< the channel's own read socket, so the port a reply arrives on says which channel it is for
+		ReadChannel() : first(0), count(0), active_user(NULL), sock(INVALID_SOCKET) { }
+	};
+
     std::string m_host;
 	bool m_simulate;
-	SOCKET m_sock_read;
+	bool m_word_reads;
 	SOCKET m_sock_write;
-    epicsMutex m_read_lock;
     epicsMutex m_write_lock;
 	struct sockaddr_in m_sa_read_send;
 	struct sockaddr_in m_sa_read_recv;
 	struct sockaddr_in m_sa_write_send;
-	void clearSocket(SOCKET fd, asynUser *pasynUser);
-    void readDataImpl(unsigned int start_address, uint32_t* data, size_t block_size, asynUser *pasynUser);
+	std::vector<ReadRequest> m_requests;  ///< the windows of read requests of all channels, each the maximum number in flight on its channel
+	ReadChannel m_channels[NumChannels];
+	double m_timeout;         ///< seconds before an unanswered read request is retransmitted, the initial value when adaptive
+	double m_max_rto;         ///< ceiling of adaptive timeouts, MAX_RTO or m_timeout if that is longer
+	int m_max_retries;        ///< retransmissions before a read fails
+	bool m_adaptive;          ///< retransmit timeout follows the measured round trip time
+	std::vector<uint32_t> m_verify_buffer;  ///< write readback, protected by m_write_lock
+	std::vector<uint32_t> m_rmw_buffer;     ///< current words for writeMasked(), protected by m_write_lock
+	epicsMutex m_request_lock;   ///< protects m_requests, the channels' active_user and m_stats against the receive thread
+	Stats m_stats;
+	Counters m_counters;         ///< only accessed with epicsAtomic operations
+	epicsMutex m_link_lock;      ///< protects m_link and the error log rate limit, taken after m_request_lock if both are needed
+	LinkState m_link;
+	int m_link_down;             ///< !m_link.up, read with epicsAtomic so the hot paths need not take m_link_lock
+	int m_timeouts;              ///< m_link.timeouts, reset with epicsAtomic by the receive thread on every reply
+	unsigned m_probe_address;    ///< what the probe reads, the last address the board answered (the firmware words until then), only used by the receive thread
+	epicsTime m_next_probe;      ///< only used by the receive thread
+	epicsTime m_last_log;        ///< when an error was last traced
+	unsigned long m_log_suppressed;  ///< errors not traced since then
+	epicsEvent m_receive_done;   ///< signalled by the receive thread as it exits
+	volatile bool m_exiting;
+	bool m_receive_thread;
+	static void receiveThreadC(void* arg);
+	void receiveThread();
+	void dispatchReply(Channel channel, const read_recv& rr, int size);
+	void receiveReplies(Channel channel, std::vector<read_recv>& rr);
+	SOCKET openReadSocket();
+	void sendReadRequest(ReadRequest& req, asynUser *pasynUser);
+	void readSizeError(const ReadRequest& req, asynUser *pasynUser);
+	double retransmitExpired(Channel channel, asynUser *pasynUser);
+	void cancelRequests(Channel channel);
+	void waitForStragglers();
+	void updateRTT(double rtt);
+	static void count(size_t& counter, size_t n = 1);
+	void fail(asynUser *pasynUser, const DAEDataError& error);
+	void checkLink(asynUser *pasynUser, unsigned start_address);
+	void linkUp();
+	void sendProbe();
+	void sendWriteRequest(unsigned int start_address, const void* data, Format format, uint32_t offset, size_t block_size, asynUser *pasynUser);
+	void checkVerify(unsigned int start_address, const void* data, Format format, uint32_t offset, const uint32_t* data_rb, size_t block_size, asynUser *pasynUser, std::vector<Mismatch>* mismatches);
 	
 public:
-	
-    DAEDataUDP(const char* host, bool simulate);
+    DAEDataUDP(const char* host, bool simulate, int options = 0, size_t window = 0, double timeout = 0.0, int retries = -1, 
+               unsigned short read_port = DAE_READ_PORT, unsigned short write_port = DAE_WRITE_PORT);
 	~DAEDataUDP();
-    void readData(unsigned int start_address, uint32_t* data, size_t block_size, asynUser *pasynUser);
-    void writeData(unsigned int start_address, const uint32_t* data, size_t block_size, bool verify, asynUser *pasynUser);
+    void readData(unsigned int start_address, uint32_t* data, size_t block_size, asynUser *pasynUser, Channel channel = BulkChannel);
+    void readData(unsigned int start_address, void* data, size_t block_size, Format format, uint32_t offset, asynUser *pasynUser, Channel channel = BulkChannel);
+    void readBlocks(const Block* blocks, size_t nblocks, asynUser *pasynUser, Channel channel = BulkChannel);
+    void writeData(unsigned int start_address, const uint32_t* data, size_t block_size, bool verify, asynUser *pasynUser, DeferredVerify* deferred = NULL);
+    void writeData(unsigned int start_address, const void* data, size_t block_size, Format format, uint32_t offset, bool verify, asynUser *pasynUser, DeferredVerify* deferred = NULL);
+    size_t writeMasked(unsigned int start_address, const uint32_t* data, const uint32_t* mask, size_t block_size, bool verify, asynUser *pasynUser, uint32_t* result = NULL);
+    static size_t formatBytes(Format format);
+    void setTimeout(double timeout, int retries);
+    void getStats(Stats& stats);
+    void getCounters(Counters& counters);
+    void getLinkState(LinkState& link);
+    static double rttBucketLimit(int bucket);
+    void verifyDeferred(DeferredVerify& deferred, asynUser *pasynUser, std::vector<Mismatch>* mismatches = NULL);
 };
+
+/// \return whether any of the trace mask bits are enabled for pasynUser, to skip building trace
+/// arguments on the success paths (older asyn versions evaluate asynPrint arguments even when it prints nothing)
+inline bool daedataTraceOn(asynUser* pasynUser, int mask)
+{
+	return (pasynTrace->getTraceMask(pasynUser) & mask) != 0;
+}
+
+#endif /* DAEDATAUDP_H */
@@ -0,0 +1,472 @@
+/// Benchmark of the DAEDataUDP read and write paths and the daedataDriver array and single word methods over loopback,
+/// against a DAEDataSim run in process (or, with -a, an external daedataSim or a real DAE). For each
+/// transfer size a run of operations is timed one after another, reporting datagrams/s, words/s, p50/p99/p999
+/// latency and heap allocations per operation made by the calling thread. Finally the latency of verified
+/// 8 word writes is measured under load: through DAEDataUDP while another thread keeps the bulk read channel
+/// busy, and through the driver while another thread makes large array reads under the port lock, as
+/// records do. Results also go to a JSON file so that runs of different versions can be compared.
+///
+/// usage: daedataUDPBench [-a host] [-o file] [-n ops] [-l latency_ms] [-p loss]
+///
+/// -a  DAE to talk to, default an in process simulator on 127.0.0.1
+/// -o  JSON results file, default daedataUDPBench.json
+/// -n  operations per small transfer size, default 2000 (multi megabyte transfers do fewer)
+/// -l  reply latency of the in process simulator, milliseconds
+/// -p  reply loss probability of the in process simulator
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <stdint.h>
+
+#include <osiSock.h>
+#include <epicsTime.h>
+#include <epicsThread.h>
+#include <epicsEvent.h>
+#include <epicsGetopt.h>
+#include <epicsStdio.h>
+
+#include "asynPortDriver.h"
+
+#include "daedataUDP.h"
+#include "daedataDriver.h"
+#include "daedataKernels.h"
+#include "daedataSim.h"
+
+static const unsigned READ_BASE = 0x100000;    ///< byte address of the region read
+static const unsigned WRITE_BASE = 0x2000000;  ///< byte address of the region written, away from READ_BASE
+static const size_t LARGE_WORDS = 1024 * 1024; ///< the multi megabyte transfer size
+static const size_t LOAD_WORDS = 65536;        ///< words per bulk read while measuring writes under load
+
+/// heap allocations by count_thread, so those of the receive and simulator threads are not counted
+static epicsThreadId count_thread = 0;
+static unsigned long allocations = 0;
+
+// the replacement operator new/delete need the exception specifications of the standard library's declarations
+#if __cplusplus >= 201103L
+#define BENCH_THROW_BAD_ALLOC
+#define BENCH_NOTHROW noexcept
+#else
+#define BENCH_THROW_BAD_ALLOC throw(std::bad_alloc)
+#define BENCH_NOTHROW throw()
+#endif
+
+void* operator new(size_t size) BENCH_THROW_BAD_ALLOC
+{
+    if (count_thread != 0 && epicsThreadGetIdSelf() == count_thread)
+    {
+        ++allocations;
+    }
+    void* p = malloc(size > 0 ? size : 1);
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) BENCH_THROW_BAD_ALLOC
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) BENCH_NOTHROW
+{
+    free(p);
+}
+
+void operator delete[](void* p) BENCH_NOTHROW
+{
+    free(p);
+}
+
+/// one line of results
+struct BenchResult
+{
+    std::string op;
+    size_t words;         ///< per operation
+    size_t ops;
+    double seconds;
+    double datagrams;     ///< sent to the DAE
+    double p50, p99, p999;  ///< seconds
+    double allocs_per_op;
+    size_t errors;        ///< operations that threw, e.g. a verify failure or timeout
+};
+
+/// the operation being timed, called ops times in a row
+class BenchOp
+{
+public:
+    virtual void run(size_t i) = 0;
+    virtual ~BenchOp() { }
+};
+
+class Bench
+{
+public:
+    Bench(const char* host, DAEDataSim* sim) : m_host(host), m_sim(sim), m_udp(NULL), m_driver(NULL)
+    {
+        memset(&m_user, 0, sizeof(m_user));
+        m_user.timeout = 1.0;
+    }
+    void runAll(size_t nops);
+    bool writeJSON(const char* filename) const;
+    DAEDataUDP* udp() { return m_udp; }
+    daedataDriver* driver() { return m_driver; }
+    asynUser* user() { return &m_user; }
+
+private:
+    std::string m_host;
+    DAEDataSim* m_sim;
+    DAEDataUDP* m_udp;
+    daedataDriver* m_driver;
+    asynUser m_user;
+    std::vector<BenchResult> m_results;
+    unsigned long datagramsReceived() const;
+    void time(const char* name, size_t words, size_t ops, size_t nominal_datagrams, BenchOp& op);
+    void underLoad(size_t nops);
+};
+
+/// datagrams the in process simulator has had, 0 if using an external DAE
+unsigned long Bench::datagramsReceived() const
+{
+    return (m_sim != NULL ? m_sim->stats().reads + m_sim->stats().writes + m_sim->stats().malformed : 0);
+}
+
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    return (sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))]);
+}
+
+/// time ops calls of op on words word transfers, each needing nominal_datagrams datagrams without retransmission
+void Bench::time(const char* name, size_t words, size_t ops, size_t nominal_datagrams, BenchOp& op)
+{
+    std::vector<double> latency;
+    latency.reserve(ops);
+    try
+    {
+        op.run(0);  // warm up, e.g. buffers sized on first use
+    }
+    catch(const std::exception&)
+    {
+    }
+    unsigned long datagrams_before = datagramsReceived();
+    unsigned long allocations_before = allocations;
+    count_thread = epicsThreadGetIdSelf();
+    epicsTime start = epicsTime::getCurrent();
+    size_t errors = 0;
+    for(size_t i=0; i<ops; ++i)
+    {
+        epicsTime op_start = epicsTime::getCurrent();
+        try
+        {
+            op.run(i);
+        }
+        catch(const std::exception& ex)
+        {
+            if (errors++ == 0)
+            {
+                fprintf(stderr, "%s %lu words: %s\n", name, (unsigned long)words, ex.what());
+            }
+        }
+        latency.push_back(epicsTime::getCurrent() - op_start);
+    }
+    double seconds = epicsTime::getCurrent() - start;
+    count_thread = 0;
+    BenchResult r;
+    r.op = name;
+    r.words = words;
+    r.ops = ops;
+    r.seconds = seconds;
+    r.datagrams = (m_sim != NULL ? (double)(datagramsReceived() - datagrams_before) : (double)(nominal_datagrams * ops));
+    std::sort(latency.begin(), latency.end());
+    r.p50 = percentile(latency, 0.5);
+    r.p99 = percentile(latency, 0.99);
+    r.p999 = percentile(latency, 0.999);
+    r.allocs_per_op = (double)(allocations - allocations_before) / ops;
+    r.errors = errors;
+    m_results.push_back(r);
+    printf("%-24s %8lu %6lu %12.0f %12.0f %9.1f %9.1f %9.1f %8.2f %6lu\n", name, (unsigned long)words, (unsigned long)ops,
+           r.datagrams / seconds, (double)words * ops / seconds, 1e6 * r.p50, 1e6 * r.p99, 1e6 * r.p999, r.allocs_per_op, (unsigned long)errors);
+    fflush(stdout);
+}
+
+class UDPRead : public BenchOp
+{
+public:
+    UDPRead(Bench& bench, size_t words, DAEDataUDP::Channel channel = DAEDataUDP::InteractiveChannel) : m_bench(bench), m_data(words), m_channel(channel)
+    {
+        memset(&m_user, 0, sizeof(m_user));
+        m_user.timeout = 1.0;
+    }
+    virtual void run(size_t i) { m_bench.udp()->readData(READ_BASE, &(m_data[0]), m_data.size(), &m_user, m_channel); }
+private:
+    Bench& m_bench;
+    std::vector<uint32_t> m_data;
+    DAEDataUDP::Channel m_channel;
+    asynUser m_user;    ///< its own, as it may be run by a Load thread
+};
+
+class UDPWrite : public BenchOp
+{
+public:
+    UDPWrite(Bench& bench, size_t words, bool verify) : m_bench(bench), m_data(words), m_verify(verify) { }
+    virtual void run(size_t i)
+    {
+        m_data[0] = (uint32_t)i;   // so a verify cannot pass on a stale readback of the last write
+        m_bench.udp()->writeData(WRITE_BASE, &(m_data[0]), m_data.size(), m_verify, m_bench.user());
+    }
+private:
+    Bench& m_bench;
+    std::vector<uint32_t> m_data;
+    bool m_verify;
+};
+
+/// readInt32Array()/writeInt32Array(), or readInt32()/writeInt32() for a single word, called as asyn's 
+/// port thread would for a waveform or longin/longout record
+class DriverIO : public BenchOp
+{
+public:
+    DriverIO(Bench& bench, size_t words, bool write, bool array) : m_bench(bench), m_data(words), m_write(write), m_array(array), m_user(NULL)
+    {
+        char drvInfo[64];
+        epicsSnprintf(drvInfo, sizeof(drvInfo), "0x%x n=%lu", (write ? WRITE_BASE : READ_BASE), (unsigned long)words);
+        m_user = pasynManager->createAsynUser(NULL, NULL);
+        m_user->timeout = 1.0;
+        if (pasynManager->connectDevice(m_user, "bench", 0) != asynSuccess ||
+            m_bench.driver()->drvUserCreate(m_user, drvInfo, NULL, NULL) != asynSuccess)
+        {
+            throw std::runtime_error(std::string("cannot connect to bench port: ") + m_user->errorMessage);
+        }
+    }
+    ~DriverIO()
+    {
+        m_bench.driver()->drvUserDestroy(m_user);
+        pasynManager->disconnect(m_user);
+        pasynManager->freeAsynUser(m_user);
+    }
+    virtual void run(size_t i)
+    {
+        asynStatus status;
+        size_t nIn = 0;
+        m_bench.driver()->lock();
+        if (m_write)
+        {
+            m_data[0] = (epicsInt32)i;
+            status = (m_array ? m_bench.driver()->writeInt32Array(m_user, &(m_data[0]), m_data.size()) : m_bench.driver()->writeInt32(m_user, m_data[0]));
+        }
+        else
+        {
+            status = (m_array ? m_bench.driver()->readInt32Array(m_user, &(m_data[0]), m_data.size(), &nIn) : m_bench.driver()->readInt32(m_user, &(m_data[0])));
+        }
+        m_bench.driver()->unlock();
+        if (status != asynSuccess)
+        {
+            throw std::runtime_error(m_user->errorMessage);
+        }
+    }
+private:
+    Bench& m_bench;
+    std::vector<epicsInt32> m_data;
+    bool m_write;
+    bool m_array;
+    asynUser* m_user;
+};
+
+void Bench::runAll(size_t nops)
+{
+    m_udp = new DAEDataUDP(m_host.c_str(), false);
+    m_driver = new daedataDriver("bench", m_host.c_str(), false, 0, 0, 0.0, 0);
+    printf("%-24s %8s %6s %12s %12s %9s %9s %9s %8s %6s\n", "operation", "words", "ops", "datagrams/s", "words/s", "p50 us", "p99 us", "p999 us", "allocs", "errors");
+    size_t sizes[] = { 1, 8, MAX_BLOCK_SIZE, LARGE_WORDS };
+    for(size_t s=0; s<sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        size_t words = sizes[s];
+        size_t ops = std::max((size_t)5, std::min(nops, 16 * LARGE_WORDS / words));
+        size_t datagrams = (words + MAX_BLOCK_SIZE - 1) / MAX_BLOCK_SIZE;
+        UDPRead read(*this, words);
+        UDPWrite write(*this, words, false);
+        UDPWrite write_verify(*this, words, true);
+        DriverIO driver_read(*this, words, false, true);
+        DriverIO driver_write(*this, words, true, true);
+        time("udp_read", words, ops, datagrams, read);
+        time("udp_write", words, ops, datagrams, write);
+        time("udp_write_verify", words, ops, 2 * datagrams, write_verify);
+        time("driver_read_array", words, ops, datagrams, driver_read);
+        time("driver_write_array", words, ops, 2 * datagrams, driver_write);
+        if (words == 1)
+        {
+            DriverIO driver_read_value(*this, words, false, false);
+            DriverIO driver_write_value(*this, words, true, false);
+            time("driver_read_int32", words, ops, datagrams, driver_read_value);
+            time("driver_write_int32", words, ops, datagrams, driver_write_value);
+        }
+    }
+    underLoad(nops);
+}
+
+/// runs an operation over and over in another thread until destroyed
+class Load
+{
+public:
+    Load(BenchOp& op) : m_op(op), m_stopping(false)
+    {
+        if (epicsThreadCreate("benchLoad", epicsThreadPriorityMedium, epicsThreadGetStackSize(epicsThreadStackMedium),
+                              (EPICSTHREADFUNC)runC, this) == 0)
+        {
+            throw std::runtime_error("epicsThreadCreate failure");
+        }
+        epicsThreadSleep(0.1);
+    }
+    ~Load()
+    {
+        m_stopping = true;
+        m_done.wait();
+    }
+private:
+    BenchOp& m_op;
+    volatile bool m_stopping;
+    epicsEvent m_done;
+    static void runC(void* arg)
+    {
+        Load* load = (Load*)arg;
+        for(size_t i=0; !load->m_stopping; ++i)
+        {
+            try
+            {
+                load->m_op.run(i);
+            }
+            catch(const std::exception&)
+            {
+            }
+        }
+        load->m_done.signal();
+    }
+};
+
+/// verified DSP block writes under load: through DAEDataUDP while the poller, here another thread, streams bulk reads,
+/// and through the driver while a large waveform record, here another thread, reads under the port lock. A record
+/// write waits for the read holding the lock to finish, which PRIO HIGH on the write record cannot shorten
+void Bench::underLoad(size_t nops)
+{
+    {
+        UDPWrite write_verify(*this, 8, true);
+        UDPRead bulk_read(*this, LOAD_WORDS, DAEDataUDP::BulkChannel);
+        Load load(bulk_read);
+        time("udp_write_verify_loaded", 8, nops, 2, write_verify);
+    }
+    {
+        DriverIO driver_write(*this, 8, true, true);
+        DriverIO driver_read(*this, LOAD_WORDS, false, true);
+        Load load(driver_read);
+        time("driver_write_array_loaded", 8, nops, 2, driver_write);
+    }
+}
+
+bool Bench::writeJSON(const char* filename) const
+{
+    FILE* f = fopen(filename, "w");
+    if (f == NULL)
+    {
+        return false;
+    }
+    char now[64];
+    epicsTime::getCurrent().strftime(now, sizeof(now), "%Y-%m-%dT%H:%M:%S");
+    fprintf(f, "{\n  \"benchmark\": \"daedataUDPBench\",\n  \"time\": \"%s\",\n  \"host\": \"%s\",\n  \"simulated\": %s,\n  \"kernels\": \"%s\",\n  \"results\": [\n",
+            now, m_host.c_str(), (m_sim != NULL ? "true" : "false"), daedataKernels().name);
+    for(size_t i=0; i<m_results.size(); ++i)
+    {
+        const BenchResult& r = m_results[i];
+        fprintf(f, "    { \"op\": \"%s\", \"words\": %lu, \"ops\": %lu, \"seconds\": %.6f, \"datagrams_per_s\": %.1f, \"words_per_s\": %.1f, "
+                   "\"p50_us\": %.2f, \"p99_us\": %.2f, \"p999_us\": %.2f, \"allocs_per_op\": %.3f, \"errors\": %lu }%s\n",
+                r.op.c_str(), (unsigned long)r.words, (unsigned long)r.ops, r.seconds, r.datagrams / r.seconds, (double)r.words * r.ops / r.seconds,
+                1e6 * r.p50, 1e6 * r.p99, 1e6 * r.p999, r.allocs_per_op, (unsigned long)r.errors, (i + 1 < m_results.size() ? "," : ""));
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+static void simThreadC(void* arg)
+{
+    ((DAEDataSim*)arg)->run();
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: daedataUDPBench [-a host] [-o file] [-n ops] [-l latency_ms] [-p loss]\n");
+    exit(1);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* host = NULL;
+    const char* filename = "daedataUDPBench.json";
+    size_t nops = 2000;
+    SimOptions sim_options;
+    int c;
+    while((c = getopt(argc, argv, "a:o:n:l:p:")) != -1)
+    {
+        switch(c)
+        {
+        case 'a':
+            host = optarg;
+            break;
+        case 'o':
+            filename = optarg;
+            break;
+        case 'n':
+            nops = strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            sim_options.latency = atof(optarg) / 1000.0;
+            break;
+        case 'p':
+            sim_options.loss = atof(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+    if (optind != argc || nops == 0)
+    {
+        usage();
+    }
+    DAEDataSim* sim = NULL;
+    try
+    {
+        if (host == NULL)
+        {
+            host = sim_options.address;
+            sim = new DAEDataSim(sim_options);
+            if (epicsThreadCreate("benchSim", epicsThreadPriorityHigh, epicsThreadGetStackSize(epicsThreadStackMedium),
+                                  (EPICSTHREADFUNC)simThreadC, sim) == 0)
+            {
+                throw std::runtime_error("epicsThreadCreate failure");
+            }
+        }
+        printf("daedataUDPBench: %s%s, %s kernels\n\n", host, (sim != NULL ? " (in process simulator)" : ""), daedataKernels().name);
+        Bench bench(host, sim);
+        bench.runAll(nops);
+        if (!bench.writeJSON(filename))
+        {
+            fprintf(stderr, "daedataUDPBench: cannot write %s\n", filename);
+            return 1;
+        }
+        printf("\nresults written to %s\n", filename);
+    }
+    catch(const std::exception& ex)
+    {
+        fprintf(stderr, "daedataUDPBench: %s\n", ex.what());
+        return 1;
+    }
+    if (sim != NULL)
+    {
+        sim->stop();
+    }
+    return 0;
+}
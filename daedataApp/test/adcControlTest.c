@@ -0,0 +1,141 @@
+/** @file adcControlTest.c
+ *
+ *  Checks the batch ADC control aSub functions against the single channel ones: for random
+ *  control blocks, ADCReadControlRegs/ADCWriteControlRegs on N channels must give the same
+ *  fields and words as N calls of ADCReadControlReg/ADCWriteControlReg. The aSub functions
+ *  are static, so ADCControl.c is compiled in here rather than linked from daedataSupport
+ */
+#include <string.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "ADCControl.c"
+#include "daedataTest.h"
+
+#define NCHAN 24    /* channels per batch, as an FPGA reads them in one block */
+#define NROUNDS 100 /* batches of random blocks */
+
+/* random control blocks of nchan channels, with the bits outside ADCControlBits zero as written by the encoders */
+static void randomBlocks(epicsUInt32* words, int nchan)
+{
+    int i, j;
+    for(i=0; i<nchan; ++i)
+    {
+        for(j=0; j<ADC_BLOCK_WORDS; ++j)
+        {
+            words[i * ADC_BLOCK_WORDS + j] = (j < ADC_STRUCT_WORDS ? randomWord() : 0);
+        }
+        words[i * ADC_BLOCK_WORDS + 4] &= 0x03ffffff;  /* unused : 38 */
+        words[i * ADC_BLOCK_WORDS + 5] = 0;
+    }
+}
+
+/* an aSub record reading nchan blocks from words into the nchan element field arrays */
+static void setupRead(aSubRecord* prec, const char* name, epicsUInt32* words, int nchan, epicsInt32 fields[ADC_NFIELDS][NCHAN])
+{
+    void** val = &prec->vala;
+    epicsEnum16* ftv = &prec->ftva;
+    epicsUInt32* nov = &prec->nova;
+    int f;
+    memset(prec, 0, sizeof(*prec));
+    strcpy(prec->name, name);
+    prec->a = words;
+    prec->fta = menuFtypeULONG;
+    prec->noa = prec->nea = nchan * ADC_BLOCK_WORDS;
+    for(f=0; f<ADC_NFIELDS; ++f)
+    {
+        val[f] = fields[f];
+        ftv[f] = menuFtypeLONG;
+        nov[f] = nchan;
+    }
+}
+
+/* an aSub record writing the nchan element field arrays as nchan blocks into words */
+static void setupWrite(aSubRecord* prec, const char* name, epicsInt32 fields[ADC_NFIELDS][NCHAN], int nchan, epicsUInt32* words)
+{
+    void** in = &prec->a;
+    epicsEnum16* ft = &prec->fta;
+    epicsUInt32* no = &prec->noa;
+    epicsUInt32* ne = &prec->nea;
+    int f;
+    memset(prec, 0, sizeof(*prec));
+    strcpy(prec->name, name);
+    for(f=0; f<ADC_NFIELDS; ++f)
+    {
+        in[f] = fields[f];
+        ft[f] = menuFtypeLONG;
+        no[f] = ne[f] = nchan;
+    }
+    prec->vala = words;
+    prec->ftva = menuFtypeULONG;
+    prec->nova = nchan * ADC_BLOCK_WORDS;
+}
+
+MAIN(adcControlTest)
+{
+    static epicsUInt32 words[NCHAN * ADC_BLOCK_WORDS], batch_words[NCHAN * ADC_BLOCK_WORDS], single_words[ADC_BLOCK_WORDS];
+    static epicsInt32 batch[ADC_NFIELDS][NCHAN], single[ADC_NFIELDS][NCHAN];
+    static epicsFloat64 doubles[ADC_NFIELDS];
+    aSubRecord rec;
+    int round, i, f, status_errors = 0, decode_errors = 0, encode_errors = 0, roundtrip_errors = 0, count_errors = 0;
+
+    testPlan(7);
+    for(round=0; round<NROUNDS; ++round)
+    {
+        randomBlocks(words, NCHAN);
+        setupRead(&rec, "batchRead", words, NCHAN, batch);
+        status_errors += (ADCReadControlRegs(&rec) != 0);
+        for(f=0; f<ADC_NFIELDS; ++f)
+        {
+            count_errors += ((&rec.neva)[f] != NCHAN);
+        }
+        for(i=0; i<NCHAN; ++i)
+        {
+            epicsInt32 one[ADC_NFIELDS][NCHAN];
+            setupRead(&rec, "singleRead", words + i * ADC_BLOCK_WORDS, 1, one);
+            status_errors += (ADCReadControlReg(&rec) != 0);
+            for(f=0; f<ADC_NFIELDS; ++f)
+            {
+                decode_errors += (one[f][0] != batch[f][i]);
+                single[f][i] = one[f][0];
+            }
+        }
+        setupWrite(&rec, "batchWrite", batch, NCHAN, batch_words);
+        status_errors += (ADCWriteControlRegs(&rec) != 0);
+        count_errors += (rec.neva != NCHAN * ADC_BLOCK_WORDS);
+        roundtrip_errors += (memcmp(batch_words, words, sizeof(words)) != 0);
+        for(i=0; i<NCHAN; ++i)
+        {
+            epicsInt32 one[ADC_NFIELDS][NCHAN];
+            for(f=0; f<ADC_NFIELDS; ++f)
+            {
+                one[f][0] = single[f][i];
+            }
+            setupWrite(&rec, "singleWrite", one, 1, single_words);
+            status_errors += (ADCWriteControlReg(&rec) != 0);
+            encode_errors += (memcmp(single_words, batch_words + i * ADC_BLOCK_WORDS, sizeof(single_words)) != 0);
+        }
+    }
+    testOk(status_errors == 0, "all %d batch and %d single channel calls succeed (%d failed)", 2 * NROUNDS, 2 * NROUNDS * NCHAN, status_errors);
+    testOk(decode_errors == 0, "batch decode of %d channels matches %d single channel decodes, %d rounds (%d fields differ)", NCHAN, NCHAN, NROUNDS, decode_errors);
+    testOk(encode_errors == 0, "batch encode matches single channel encodes (%d blocks differ)", encode_errors);
+    testOk(roundtrip_errors == 0, "batch encode of the decoded fields gives back the original blocks (%d rounds differ)", roundtrip_errors);
+    testOk(count_errors == 0, "batch functions set NEVx to the number of channels (%d wrong)", count_errors);
+
+    /* the single channel functions only check A and VALA, so existing records with other types in B..N keep working */
+    setupRead(&rec, "singleReadDouble", words, 1, single);
+    for(f=1; f<ADC_NFIELDS; ++f)
+    {
+        (&rec.valb)[f - 1] = &doubles[f];
+        (&rec.ftvb)[f - 1] = menuFtypeDOUBLE;
+    }
+    testOk(ADCReadControlReg(&rec) == 0, "ADCReadControlReg accepts VALB..VALN that are not LONG");
+
+    /* whereas the batch functions check every field array */
+    setupRead(&rec, "batchReadDouble", words, NCHAN, batch);
+    rec.valb = doubles;
+    rec.ftvb = menuFtypeDOUBLE;
+    testOk(ADCReadControlRegs(&rec) != 0, "ADCReadControlRegs rejects a VALB that is not LONG");
+    return testDone();
+}
@@ -0,0 +1,23 @@
+#ifndef DAEDATATEST_H
+#define DAEDATATEST_H
+
+/** @file daedataTest.h
+ *
+ *  Scaffolding shared by the unit tests, which are C and C++
+ */
+#include <epicsTypes.h>
+
+/** the shipped register map, tests are run from the O.<arch> directory */
+#define MAP_FILE "../../Db/adcControl.map"
+
+/** xorshift, so the random data of a test is the same on every platform and every run */
+static epicsUInt32 randomWord(void)
+{
+    static epicsUInt32 x = 2463534242u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+#endif /* DAEDATATEST_H */
@@ -0,0 +1,107 @@
+/// Checks DAEDataUDP::writeMasked() against a DAEDataSim run in process: random masked writes of the
+/// fields of the shipped adcControl.map, as the driver makes them for asynUInt32Digital records, must
+/// change just the masked bits of the field written and send just the words that change
+
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <stdexcept>
+#include <stdint.h>
+
+#include <epicsTypes.h>
+#include <epicsThread.h>
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "daedataUDP.h"
+#include "daedataRegisterMap.h"
+#include "daedataSim.h"
+#include "daedataTest.h"
+
+#define NWRITES 200
+#define BLOCK_ADDRESS 0x10004
+
+static epicsUInt32 widthMask(const DAEDataRegisterMap::Field& f)
+{
+    return (f.width < 32 ? (1u << f.width) - 1 : 0xffffffffu);
+}
+
+static void simThreadC(void* arg)
+{
+    ((DAEDataSim*)arg)->run();
+}
+
+MAIN(maskedWriteTest)
+{
+    testPlan(5);
+    DAEDataRegisterMap map;
+    SimOptions sim_options;
+    sim_options.read_port = sim_options.write_port = 0;   // free ports, so a daedataSim or IOC on this host or another test run cannot clash
+    DAEDataSim* sim = NULL;
+    DAEDataUDP* udp = NULL;
+    try
+    {
+        map.load(MAP_FILE);
+        sim = new DAEDataSim(sim_options);
+        if (epicsThreadCreate("testSim", epicsThreadPriorityHigh, epicsThreadGetStackSize(epicsThreadStackMedium),
+                              (EPICSTHREADFUNC)simThreadC, sim) == 0)
+        {
+            throw std::runtime_error("epicsThreadCreate failure");
+        }
+        udp = new DAEDataUDP(sim_options.address, false, 0, 0, 0.0, -1, sim->readPort(), sim->writePort());
+    }
+    catch(const std::exception& ex)
+    {
+        testAbort("%s", ex.what());
+    }
+    const size_t nwords = map.nwords();
+    std::vector<epicsUInt32> initial(nwords), before(nwords), after(nwords), words(nwords), masks(nwords);
+    for(size_t i=0; i<nwords; ++i)
+    {
+        initial[i] = randomWord();
+    }
+    int field_errors = 0, other_errors = 0, count_errors = 0, failures = 0;
+    try
+    {
+        udp->writeData(BLOCK_ADDRESS, &initial[0], nwords, true, NULL);
+        udp->readData(BLOCK_ADDRESS, &before[0], nwords, NULL);
+        testOk(before == initial, "%u word block written and read back", (unsigned)nwords);
+        for(int n=0; n<NWRITES; ++n)
+        {
+            const DAEDataRegisterMap::Field& f = map.fields()[randomWord() % map.fields().size()];
+            epicsUInt32 value = randomWord() & widthMask(f);
+            epicsUInt32 mask = (n % 2 == 0 ? randomWord() : 0xffffffffu);   // half partial masks, half whole fields
+            std::fill(words.begin(), words.end(), 0);
+            std::fill(masks.begin(), masks.end(), 0);
+            DAEDataRegisterMap::insert(f, value, mask, &words[0], &masks[0]);
+            size_t nwritten = udp->writeMasked(BLOCK_ADDRESS, &words[0], &masks[0], nwords, true, NULL);
+            udp->readData(BLOCK_ADDRESS, &after[0], nwords, NULL);
+            epicsUInt32 want = ((DAEDataRegisterMap::extract(f, &before[0]) & ~mask) | (value & mask)) & widthMask(f);
+            field_errors += (DAEDataRegisterMap::extract(f, &after[0]) != want);
+            for(size_t g=0; g<map.fields().size(); ++g)
+            {
+                const DAEDataRegisterMap::Field& other = map.fields()[g];
+                other_errors += (&other != &f && DAEDataRegisterMap::extract(other, &after[0]) != DAEDataRegisterMap::extract(other, &before[0]));
+            }
+            size_t nchanged = 0;
+            for(size_t i=0; i<nwords; ++i)
+            {
+                nchanged += (after[i] != before[i]);
+            }
+            count_errors += (nwritten != nchanged);
+            before = after;
+        }
+    }
+    catch(const std::exception& ex)
+    {
+        ++failures;
+        testDiag("%s", ex.what());
+    }
+    testOk(failures == 0, "%d masked writes succeed", NWRITES);
+    testOk(field_errors == 0, "masked writes set the masked bits of the field and keep the others (%d differ)", field_errors);
+    testOk(other_errors == 0, "masked writes leave the other fields alone (%d changed)", other_errors);
+    testOk(count_errors == 0, "masked writes send just the words that change (%d wrong counts)", count_errors);
+    delete udp;
+    sim->stop();
+    return testDone();
+}
@@ -0,0 +1,161 @@
+/// Checks DAEDataRegisterMap against the C bit field layout it replaces: the shipped adcControl.map
+/// must decode (and encode) random blocks exactly as the ADCControlBits struct of ADCControl.c does
+
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <stdint.h>
+
+#include <epicsTypes.h>
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "daedataRegisterMap.h"
+#include "daedataTest.h"
+
+/// as in ADCControl.c
+typedef struct
+{
+    uint64_t spec_select : 4;
+    uint64_t overflow_select : 4;
+    uint64_t dsp_gain : 2;
+    uint64_t accept_all : 1;
+    uint64_t lld : 22;
+    uint64_t start_slope_cut : 22;
+    uint64_t uld0 : 9;
+
+    uint64_t uld1 : 13;
+    uint64_t second_deriv_cut : 22;
+    uint64_t max_slope_cut : 22;
+    uint64_t prescale_selection0 : 7;
+
+    uint64_t prescale_selection1 : 15;
+    uint64_t start_slope_bits : 3;
+    uint64_t max_slope_bits : 3;
+    uint64_t second_deriv_bits : 3;
+    uint64_t misplace_bits : 2;
+    uint64_t unused : 38;
+} ADCControlBits;
+
+#define NBLOCKS 10000
+#define NFIELDS 14
+
+/// the map's field names, in the order of fieldValue()
+static const char* field_names[NFIELDS] = { "SPECSEL", "OVFSEL", "DSPGAIN", "ACCEPTALL", "LLD", "SSCUT", "ULD",
+    "SDCUT", "MSCUT", "PSSEL", "SSBITS", "MSBITS", "SDBITS", "MISBITS" };
+
+static epicsUInt32 fieldValue(const ADCControlBits& a, int i)
+{
+    switch(i)
+    {
+    case 0: return (epicsUInt32)a.spec_select;
+    case 1: return (epicsUInt32)a.overflow_select;
+    case 2: return (epicsUInt32)a.dsp_gain;
+    case 3: return (epicsUInt32)a.accept_all;
+    case 4: return (epicsUInt32)a.lld;
+    case 5: return (epicsUInt32)a.start_slope_cut;
+    case 6: return (epicsUInt32)(a.uld0 | (a.uld1 << 9));
+    case 7: return (epicsUInt32)a.second_deriv_cut;
+    case 8: return (epicsUInt32)a.max_slope_cut;
+    case 9: return (epicsUInt32)(a.prescale_selection0 | (a.prescale_selection1 << 7));
+    case 10: return (epicsUInt32)a.start_slope_bits;
+    case 11: return (epicsUInt32)a.max_slope_bits;
+    case 12: return (epicsUInt32)a.second_deriv_bits;
+    default: return (epicsUInt32)a.misplace_bits;
+    }
+}
+
+static const DAEDataRegisterMap::Field* findField(const DAEDataRegisterMap& map, const char* name)
+{
+    for(size_t i=0; i<map.fields().size(); ++i)
+    {
+        if (map.fields()[i].name == name)
+        {
+            return &(map.fields()[i]);
+        }
+    }
+    return NULL;
+}
+
+MAIN(registerMapTest)
+{
+    testPlan(2 + 2 * NFIELDS);
+    DAEDataRegisterMap map;
+    try
+    {
+        map.load(MAP_FILE);
+    }
+    catch(const std::exception& ex)
+    {
+        testAbort("%s", ex.what());
+    }
+    testOk(map.fields().size() == NFIELDS, "%u fields loaded", (unsigned)map.fields().size());
+    const DAEDataRegisterMap::Field* fields[NFIELDS];
+    bool found = true;
+    for(int f=0; f<NFIELDS; ++f)
+    {
+        found = ((fields[f] = findField(map, field_names[f])) != NULL) && found;
+    }
+    testOk(found && map.nwords() * sizeof(epicsUInt32) <= sizeof(ADCControlBits), "all fields found within the %u word struct",
+           (unsigned)(sizeof(ADCControlBits) / sizeof(epicsUInt32)));
+    if (!found)
+    {
+        testAbort("%s does not match ADCControlBits", MAP_FILE);
+    }
+
+    // decode: extract() of every field of random blocks against the struct's bit fields
+    int decode_errors[NFIELDS] = { 0 };
+    for(int n=0; n<NBLOCKS; ++n)
+    {
+        epicsUInt32 words[sizeof(ADCControlBits) / sizeof(epicsUInt32)];
+        ADCControlBits a;
+        for(size_t i=0; i<sizeof(words) / sizeof(epicsUInt32); ++i)
+        {
+            words[i] = randomWord();
+        }
+        memcpy(&a, words, sizeof(a));
+        for(int f=0; f<NFIELDS; ++f)
+        {
+            if (DAEDataRegisterMap::extract(*fields[f], words) != fieldValue(a, f))
+            {
+                ++decode_errors[f];
+            }
+        }
+    }
+    for(int f=0; f<NFIELDS; ++f)
+    {
+        testOk(decode_errors[f] == 0, "%s decodes as ADCControlBits in %d random blocks (%d differ)", field_names[f], NBLOCKS, decode_errors[f]);
+    }
+
+    // encode: insert() a random value of one field into a random block, which must change just that bit field
+    int encode_errors[NFIELDS] = { 0 };
+    for(int n=0; n<NBLOCKS; ++n)
+    {
+        int f = n % NFIELDS;
+        epicsUInt32 words[sizeof(ADCControlBits) / sizeof(epicsUInt32)], masks[sizeof(ADCControlBits) / sizeof(epicsUInt32)] = { 0 };
+        ADCControlBits before, after;
+        for(size_t i=0; i<sizeof(words) / sizeof(epicsUInt32); ++i)
+        {
+            words[i] = randomWord();
+        }
+        memcpy(&before, words, sizeof(before));
+        epicsUInt32 value = randomWord() & (fields[f]->width < 32 ? (1u << fields[f]->width) - 1 : 0xffffffffu);
+        DAEDataRegisterMap::insert(*fields[f], value, 0xffffffffu, words, masks);
+        memcpy(&after, words, sizeof(after));
+        bool ok = (fieldValue(after, f) == value);
+        for(int g=0; g<NFIELDS; ++g)
+        {
+            ok = ok && (g == f || fieldValue(after, g) == fieldValue(before, g));
+        }
+        ok = ok && (after.unused == before.unused);
+        if (!ok)
+        {
+            ++encode_errors[f];
+        }
+    }
+    for(int f=0; f<NFIELDS; ++f)
+    {
+        testOk(encode_errors[f] == 0, "%s encodes as ADCControlBits leaving the other fields alone (%d differ)", field_names[f], encode_errors[f]);
+    }
+    return testDone();
+}
@@ -12,10 +12,24 @@ dbLoadDatabase "dbd/daedata.dbd"
 daedata_registerRecordDeviceDriver pdbbase
 
 #daedataConfigure("dae","192.168.1.220")
+## several DAE boards on one port, asyn address 0, 1, ... in host order
+#daedataConfigure("dae","192.168.1.220,192.168.1.221")
+## 127.0.0.1 with bin/<arch>/daedataSim running on this machine for testing without hardware
 daedataConfigure("dae","127.0.0.1")
 
+## decode the FPGA0 DSP control words into the DSP0_* parameters of the FE:FPGA:DSP:0: records, read every second
+daedataRegisterMap("dae","db/adcControl.map",0x10004,"DSP0_",1)
+## and for board 1 of a multi-device port
+#daedataRegisterMap("dae","db/adcControl.map",0x10004,"DSP0_",1,1)
+
+## snapshots cover the register map blocks plus any ranges added here, e.g. the rest of the FPGA0 setup bank.
+## After iocInit: daedataSnapshot("dae","dae0.snap") to save, daedataSnapshotDiff("dae","dae0.snap") to compare
+## and daedataSnapshotRestore("dae","dae0.snap") to write back just the words that differ
+#daedataSnapshotRange("dae",0x10000,64)
+
 ## Load record instances
 dbLoadRecords("db/daedata.db","P=$(MYPVPREFIX),PORT=dae")
+#dbLoadRecords("db/daedata.db","P=$(MYPVPREFIX)B1:,PORT=dae,BOARD=1")
 
 cd ${TOP}/iocBoot/${IOC}
 